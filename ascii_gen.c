@@ -18,6 +18,8 @@
 #include "utils.h"
 #include "config.h"
 #include "fetch_sw.h"
+#include "sampler.h"
+#include "outbuf.h"
 
 
 
@@ -106,241 +108,93 @@ int export_ascii_art(const char *filename)
 	return 0;
 }
 
-int hex_to_true_color(const char *hex_color)
+static const char *token_value(const struct fmt_token *t)
 {
-	long color_val;
-	int r, g, b;
-	const char *ptr = hex_color;
-	char hex_part[7];
-	size_t len_ptr;
+	return t->text ? t->text : placeholder_value_cached(&t->ref);
+}
 
-	if (!hex_color)
-		return -1;
+void print_info_line_idx(size_t idx, const struct cfetch_cfg *cfg, const struct color *restore_color)
+{
+	const struct line_cfg *lc;
+	size_t k;
 
-	if (*ptr == '#')
-		ptr++;
-	
-	len_ptr = strlen(ptr);
-	if (len_ptr != 6 && len_ptr != 8)
-		return -1;
+	if (idx >= cfg->lines_count)
+		return;
+	lc = &cfg->lines[idx];
+	if (!lc->present || !lc->format)
+		return;
+
+	for (k = 0; k < lc->tokens_count; k++) {
+		const struct fmt_token *t = &lc->tokens[k];
 
-	strncpy(hex_part, ptr, 6);
-	hex_part[6] = '\0';
+		if (t->kind == FMT_TEXT)
+			out_write(t->text, t->len);
+		else if (t->kind == FMT_VALUE)
+			out_puts(token_value(t));
+		else
+			color_emit(t->color);
+	}
+	color_emit(restore_color);
+}
 
-	color_val = strtol(hex_part, NULL, 16);
+static size_t str_width(const char *s)
+{
+	return s ? utf8_width(s, strlen(s)) : 0;
+}
 
-	r = (color_val >> 16) & 0xFF;
-	g = (color_val >> 8) & 0xFF;
-	b = color_val & 0xFF;
+size_t line_plain_width(const struct line_cfg *lc)
+{
+	size_t k, width = 0;
 
-	printf("\x1b[0m");
-	printf("\x1b[38;2;%d;%d;%dm", r, g, b);
+	if (!lc || !lc->present || !lc->format)
+		return 0;
+	for (k = 0; k < lc->tokens_count; k++) {
+		const struct fmt_token *t = &lc->tokens[k];
 
-	if (strcmp(hex_part, "989ef7") == 0 || strcmp(hex_part, "FF0000") == 0 || strcmp(hex_part, "7EB4DA") == 0 || strcmp(hex_part, "5277C3") == 0) {
-		printf("\x1b[1m");
+		if (t->kind == FMT_TEXT)
+			width += t->width;
+		else if (t->kind == FMT_VALUE)
+			width += str_width(token_value(t));
 	}
-
-	return 0;
+	return width;
 }
 
 
-
-void print_info_line_idx(size_t idx, const struct cfetch_cfg *cfg, const char *restore_color)
+int info_lines_need_sampler(const struct cfetch_cfg *cfg)
 {
-	const struct line_cfg *lc;
-	const char *fmt;
-	const char *col_all;
-	const char *col_lbl;
-	const char *col_data;
-	const char *p;
-
-	if (idx >= cfg->lines_count)
-		return;
-	lc = &cfg->lines[idx];
-	if (!lc->present || !lc->format)
-		return;
+	size_t i, k;
 
-	fmt = lc->format;
-	col_all = lc->color;
-	col_lbl = lc->label_color ? lc->label_color : cfg->default_label_color;
-	col_data = lc->data_color ? lc->data_color : cfg->default_data_color;
-
-	if (col_all) {
-		hex_to_true_color(col_all);
-		p = fmt;
-		while (*p) {
-			const char *b = strchr(p, '%');
-			if (!b) {
-				printf("%s", p);
-				break;
-			}
-			if (b > p)
-				printf("%.*s", (int)(b - p), p);
-			{
-				const char *e = strchr(b + 1, '%');
-				if (!e) {
-					printf("%s", b);
-					break;
-				}
-				if (e > b + 1) {
-					char *name = strndup(b + 1, (size_t)(e - (b + 1)));
-					char *val = line_force_get_dup(lc, name);
-					if (!val)
-						val = placeholder_value(name);
-					free(name);
-					if (val) {
-						printf("%s", val);
-						free(val);
-					}
-				}
-				p = e + 1;
-			}
-		}
-		hex_to_true_color(restore_color);
-		return;
-	}
+	for (i = 0; i < cfg->lines_count; i++) {
+		const struct line_cfg *lc = &cfg->lines[i];
 
-	p = fmt;
-	while (*p) {
-		const char *b = strchr(p, '%');
-		if (!b) {
-			if (col_lbl)
-				hex_to_true_color(col_lbl);
-			printf("%s", p);
-			break;
-		}
-		if (b > p) {
-			if (col_lbl)
-				hex_to_true_color(col_lbl);
-			printf("%.*s", (int)(b - p), p);
-		}
-		{
-			const char *e = strchr(b + 1, '%');
-			if (!e) {
-				if (col_lbl)
-					hex_to_true_color(col_lbl);
-				printf("%s", b);
-				break;
-			}
-			if (e > b + 1) {
-				char *name = strndup(b + 1, (size_t)(e - (b + 1)));
-				char *val = line_force_get_dup(lc, name);
-				if (!val)
-					val = placeholder_value(name);
-				free(name);
-				if (val) {
-					if (col_data)
-						hex_to_true_color(col_data);
-					printf("%s", val);
-					free(val);
-				}
-			}
-			p = e + 1;
-		}
+		if (!lc->present)
+			continue;
+		for (k = 0; k < lc->tokens_count; k++)
+			if (lc->tokens[k].kind == FMT_VALUE && !lc->tokens[k].text &&
+			    placeholder_ref_sampled(&lc->tokens[k].ref))
+				return 1;
 	}
-	hex_to_true_color(restore_color);
+	return 0;
 }
 
-char *line_render_plain(const struct line_cfg *lc)
+void prefetch_info_values(const struct cfetch_cfg *cfg)
 {
-	const char *p;
-	char *out;
-	size_t cap = 128;
-	size_t len = 0;
+	size_t i, k;
 
-	if (!lc || !lc->present || !lc->format)
-		return xstrdup("");
-	out = malloc(cap);
-	if (!out)
-		return xstrdup("");
-	out[0] = '\0';
-	p = lc->format;
-	while (*p) {
-		const char *b = strchr(p, '%');
-		if (!b) {
-			size_t n = strlen(p);
-			if (len + n + 1 > cap) {
-				size_t nc = (len + n + 1) * 2;
-				char *tmp = realloc(out, nc);
-				if (!tmp) {
-					free(out);
-					return xstrdup("");
-				}
-				out = tmp;
-				cap = nc;
-			}
-			memcpy(out + len, p, n);
-			len += n;
-			out[len] = '\0';
-			break;
-		}
-		if (b > p) {
-			size_t n = (size_t)(b - p);
-			if (len + n + 1 > cap) {
-				size_t nc = (len + n + 1) * 2;
-				char *tmp = realloc(out, nc);
-				if (!tmp) {
-					free(out);
-					return xstrdup("");
-				}
-				out = tmp;
-				cap = nc;
-			}
-			memcpy(out + len, p, n);
-			len += n;
-			out[len] = '\0';
-		}
-		{
-			const char *e = strchr(b + 1, '%');
-			if (!e) {
-				size_t n = strlen(b);
-				if (len + n + 1 > cap) {
-					size_t nc = (len + n + 1) * 2;
-					char *tmp = realloc(out, nc);
-					if (!tmp) {
-						free(out);
-						return xstrdup("");
-					}
-					out = tmp;
-					cap = nc;
-				}
-				memcpy(out + len, b, n);
-				len += n;
-				out[len] = '\0';
-				break;
-			}
-			if (e > b + 1) {
-				char *name = strndup(b + 1, (size_t)(e - (b + 1)));
-				char *val = line_force_get_dup(lc, name);
-				if (!val)
-					val = placeholder_value(name);
-				free(name);
-				if (val) {
-					size_t n = strlen(val);
-					if (len + n + 1 > cap) {
-						size_t nc = (len + n + 1) * 2;
-						char *tmp = realloc(out, nc);
-						if (!tmp) {
-							free(val);
-							free(out);
-							return xstrdup("");
-						}
-						out = tmp;
-						cap = nc;
-					}
-					memcpy(out + len, val, n);
-					len += n;
-					out[len] = '\0';
-					free(val);
-				}
-			}
-			p = e + 1;
+	for (i = 0; i < cfg->lines_count; i++) {
+		const struct line_cfg *lc = &cfg->lines[i];
+
+		if (!lc->present)
+			continue;
+		for (k = 0; k < lc->tokens_count; k++) {
+			const struct fmt_token *t = &lc->tokens[k];
+
+			if (t->kind == FMT_VALUE && !t->text && !placeholder_ref_sampled(&t->ref))
+				placeholder_value_cached(&t->ref);
 		}
 	}
-	return out;
 }
 
-
 void build_art_rows(const char *art[], struct art_row **out_rows, size_t *out_count, size_t *out_max)
 {
 	size_t cap = 16;
@@ -371,19 +225,19 @@ void build_art_rows(const char *art[], struct art_row **out_rows, size_t *out_co
 			while (art[j]) {
 				if (art[j][0] == '#') { j++; continue; }
 				if (art[j][0] == '$') {
-					visual_len += strlen(art[j] + 1);
+					visual_len += str_width(art[j] + 1);
 					j++;
 					continue;
 				}
 				break;
 			}
 		} else {
-			visual_len += strlen(art[j]);
+			visual_len += str_width(art[j]);
 			j++;
 			while (art[j]) {
 				if (art[j][0] == '#') { j++; continue; }
 				if (art[j][0] == '$') {
-					visual_len += strlen(art[j] + 1);
+					visual_len += str_width(art[j] + 1);
 					j++;
 					continue;
 				}
@@ -413,154 +267,151 @@ void build_art_rows(const char *art[], struct art_row **out_rows, size_t *out_co
 	*out_max = max_line_length;
 }
 
-void print_art_row_segments(const char *art[], int start, int end, char *latest_hex_color, size_t latest_hex_color_sz)
+/* Art color rows are parsed once per render; other rows map to NULL. */
+static const struct color **art_colors_build(const char *art[])
+{
+	const struct color **colors;
+	size_t n = 0, k;
+
+	while (art[n])
+		n++;
+	colors = calloc(n ? n : 1, sizeof(*colors));
+	if (!colors)
+		return NULL;
+	for (k = 0; k < n; k++)
+		if (art[k][0] == '#')
+			colors[k] = color_get(art[k]);
+	return colors;
+}
+
+void print_art_row_segments(const char *art[], const struct color **colors, int start, int end,
+			    const struct color **latest)
 {
 	int k;
 
 	for (k = start; k < end; ++k) {
 		if (art[k][0] == '#') {
-			hex_to_true_color(art[k]);
-			strncpy(last_hexcolor, art[k], sizeof(last_hexcolor) - 1);
-			last_hexcolor[sizeof(last_hexcolor) - 1] = '\0';
-			strncpy(latest_hex_color, art[k], latest_hex_color_sz - 1);
-			latest_hex_color[latest_hex_color_sz - 1] = '\0';
+			const struct color *c = colors ? colors[k] : color_get(art[k]);
+
+			if (c) {
+				color_emit(c);
+				*latest = c;
+			}
 			continue;
 		}
 		if (art[k][0] == '$') {
-			printf("%s", art[k] + 1);
+			out_puts(art[k] + 1);
 		} else {
-			printf("%s", art[k]);
+			out_puts(art[k]);
 		}
 	}
 }
 
-char last_hexcolor[16];
-
-
-
-void print_repeat_char(const char *color_hex, const char *restore_hex, char ch, size_t count)
+void print_repeat_char(const struct color *color, const struct color *restore, char ch, size_t count)
 {
-	size_t i;
+	char unit[2] = { ch, '\0' };
 
-	if (color_hex)
-		hex_to_true_color(color_hex);
-	for (i = 0; i < count; i++)
-		putchar(ch);
-	if (restore_hex)
-		hex_to_true_color(restore_hex);
+	color_emit(color);
+	out_repeat(unit, count);
+	color_emit(restore);
 }
 
-void print_repeat_utf8(const char *color_hex, const char *restore_hex, const char *glyph, size_t count)
+void print_repeat_utf8(const struct color *color, const struct color *restore, const char *glyph, size_t count)
 {
-	size_t i;
-
-	if (color_hex)
-		hex_to_true_color(color_hex);
-	for (i = 0; i < count; i++)
-		printf("%s", glyph);
-	if (restore_hex)
-		hex_to_true_color(restore_hex);
+	color_emit(color);
+	out_repeat(glyph, count);
+	color_emit(restore);
 }
 
-void print_titled_border_line(const char *left_ch, const char *right_ch, const char *title, size_t inner_width, const char *frame_color, const char *restore_color)
+void print_titled_border_line(const char *left_ch, const char *right_ch, const char *title, size_t inner_width, const struct color *frame_color, const struct color *restore_color)
 {
-	size_t title_len = strlen_safe(title);
+	size_t title_width = 0;
+	size_t title_len = title ? utf8_prefix_width(title, strlen(title), inner_width, &title_width) : 0;
 	size_t total = inner_width;
 	size_t left_dash;
 	size_t right_dash;
 
-	if (title_len > total)
-		title_len = total;
-	left_dash = (total - title_len) / 2;
-	right_dash = total - title_len - left_dash;
+	left_dash = (total - title_width) / 2;
+	right_dash = total - title_width - left_dash;
 
-	hex_to_true_color(frame_color);
-	printf("%s", left_ch);
+	color_emit(frame_color);
+	out_puts(left_ch);
 	print_repeat_utf8(frame_color, NULL, "─", left_dash);
 	if (title && title_len > 0)
-		printf("%.*s", (int)title_len, title);
+		out_write(title, title_len);
 	print_repeat_utf8(frame_color, NULL, "─", right_dash);
-	printf("%s", right_ch);
-	hex_to_true_color(restore_color);
+	out_puts(right_ch);
+	color_emit(restore_color);
 }
 
-void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
+static void out_pad(int n)
+{
+	if (n > 0)
+		out_blank((size_t)n);
+}
+
+static void render_configured(const char *art[], const struct color **art_colors,
+			      const struct cfetch_cfg *cfg)
 {
-	char latest_hex_color[16] = "#000000";
+	const struct color *latest_color = color_get("#000000");
 	struct art_row *rows = NULL;
 	size_t row_cnt = 0;
 	size_t max_art_len = 0;
 	size_t i;
 
+	prefetch_info_values(cfg);
+	sampler_end();
 	build_art_rows(art, &rows, &row_cnt, &max_art_len);
 
 	if (frame_kind(cfg) == 0) {
 		size_t line_idx = 0;
 		for (i = 0; i < row_cnt; i++) {
-			print_art_row_segments(art, rows[i].cstart, rows[i].end, latest_hex_color, sizeof(latest_hex_color));
+			print_art_row_segments(art, art_colors, rows[i].cstart, rows[i].end, &latest_color);
 			{
 				int padding = (int)max_art_len - (int)rows[i].visual_len;
-				int p;
 
 				if (padding < 0)
 					padding = 0;
-				for (p = 0; p < padding + cfg->info_padding; ++p)
-					putchar(' ');
+				out_pad(padding + cfg->info_padding);
 			}
-			print_info_line_idx(line_idx, cfg, latest_hex_color);
-			printf("\n");
+			print_info_line_idx(line_idx, cfg, latest_color);
+			out_putc('\n');
 			line_idx++;
 		}
-		printf("\x1b[0m");
+		color_reset();
 		free(rows);
 		return;
 	} else if (frame_kind(cfg) == 1) {
 		size_t line_idx = 0;
-		const char *fcol = frame_color_or_default(cfg);
+		const struct color *fcol = color_get(frame_color_or_default(cfg));
 		for (i = 0; i < row_cnt; i++) {
-			char *plain = NULL;
 			size_t plen = 0;
-			print_art_row_segments(art, rows[i].cstart, rows[i].end, latest_hex_color, sizeof(latest_hex_color));
+			print_art_row_segments(art, art_colors, rows[i].cstart, rows[i].end, &latest_color);
 			{
 				int padding = (int)max_art_len - (int)rows[i].visual_len;
-				int p;
 
 				if (padding < 0)
 					padding = 0;
-				for (p = 0; p < padding + cfg->info_padding; ++p)
-					putchar(' ');
+				out_pad(padding + cfg->info_padding);
 			}
-			print_info_line_idx(line_idx, cfg, latest_hex_color);
-			printf("\n");
+			print_info_line_idx(line_idx, cfg, latest_color);
+			out_putc('\n');
 
-			{
-				size_t spaces = max_art_len + cfg->info_padding;
-				size_t s;
-				for (s = 0; s < spaces; s++)
-					putchar(' ');
-			}
-			if (line_idx < cfg->lines_count && cfg->lines[line_idx].present && cfg->lines[line_idx].format) {
-				plain = line_render_plain(&cfg->lines[line_idx]);
-				plen = strlen_safe(plain);
-			} else {
-				plen = 0;
-			}
-			print_repeat_utf8(fcol, latest_hex_color, "─", plen);
-			printf("\n");
-			if (plain)
-				free(plain);
+			out_pad((int)(max_art_len + cfg->info_padding));
+			plen = line_idx < cfg->lines_count ? line_plain_width(&cfg->lines[line_idx]) : 0;
+			print_repeat_utf8(fcol, latest_color, "─", plen);
+			out_putc('\n');
 			line_idx++;
 		}
-		printf("\x1b[0m");
+		color_reset();
 		free(rows);
 		return;
 	} else if (frame_kind(cfg) == 2) {
 		size_t j;
-		const char *fcol = frame_color_or_default(cfg);
+		const struct color *fcol = color_get(frame_color_or_default(cfg));
 		size_t lines_cap = 16;
 		size_t lines_cnt = 0;
 		size_t *idxs = malloc(lines_cap * sizeof(*idxs));
-		char **plains = NULL;
 		size_t *plens = NULL;
 		size_t inner_width = 0;
 		size_t box_rows;
@@ -586,18 +437,14 @@ void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
 			idxs[lines_cnt++] = j;
 		}
 
-		plains = malloc(lines_cnt * sizeof(*plains));
 		plens = malloc(lines_cnt * sizeof(*plens));
-		if (!plains || !plens) {
-			free(plains);
-			free(plens);
+		if (!plens) {
 			free(idxs);
 			free(rows);
 			return;
 		}
 		for (j = 0; j < lines_cnt; j++) {
-			plains[j] = line_render_plain(&cfg->lines[idxs[j]]);
-			plens[j] = strlen_safe(plains[j]);
+			plens[j] = line_plain_width(&cfg->lines[idxs[j]]);
 			if (plens[j] > inner_width)
 				inner_width = plens[j];
 		}
@@ -607,74 +454,62 @@ void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
 
 		for (r = 0; r < total_rows; r++) {
 			if (r < row_cnt) {
-				print_art_row_segments(art, rows[r].cstart, rows[r].end, latest_hex_color, sizeof(latest_hex_color));
+				print_art_row_segments(art, art_colors, rows[r].cstart, rows[r].end, &latest_color);
 				{
 					int padding = (int)max_art_len - (int)rows[r].visual_len;
-					int p;
 
 					if (padding < 0)
 						padding = 0;
-					for (p = 0; p < padding + cfg->info_padding; ++p)
-						putchar(' ');
+					out_pad(padding + cfg->info_padding);
 				}
 			} else {
-				int p;
-				for (p = 0; p < (int)(max_art_len + cfg->info_padding); ++p)
-					putchar(' ');
+				out_pad((int)(max_art_len + cfg->info_padding));
 			}
 
 			if (r == 0) {
-				hex_to_true_color(fcol);
-				printf("┌");
+				color_emit(fcol);
+				out_puts("┌");
 				print_repeat_utf8(fcol, NULL, "─", inner_width + 2);
-				printf("┐");
-				hex_to_true_color(latest_hex_color);
+				out_puts("┐");
+				color_emit(latest_color);
 			} else if (r == box_rows - 1) {
-				hex_to_true_color(fcol);
-				printf("└");
+				color_emit(fcol);
+				out_puts("└");
 				print_repeat_utf8(fcol, NULL, "─", inner_width + 2);
-				printf("┘");
-				hex_to_true_color(latest_hex_color);
+				out_puts("┘");
+				color_emit(latest_color);
 			} else if (r - 1 < lines_cnt) {
 				size_t li = r - 1;
 				size_t pad = inner_width > plens[li] ? inner_width - plens[li] : 0;
 
-				hex_to_true_color(fcol);
-				printf("│ ");
-				hex_to_true_color(latest_hex_color);
-				print_info_line_idx(idxs[li], cfg, latest_hex_color);
-				hex_to_true_color(fcol);
-				{
-					size_t s;
-					for (s = 0; s < pad + 1; s++)
-						putchar(' ');
-				}
-				printf("│");
-				hex_to_true_color(latest_hex_color);
+				color_emit(fcol);
+				out_puts("│ ");
+				color_emit(latest_color);
+				print_info_line_idx(idxs[li], cfg, latest_color);
+				color_emit(fcol);
+				out_blank(pad + 1);
+				out_puts("│");
+				color_emit(latest_color);
 			}
-			printf("\n");
+			out_putc('\n');
 		}
 
-		for (j = 0; j < lines_cnt; j++)
-			free(plains[j]);
-		free(plains);
 		free(plens);
 		free(idxs);
-		printf("\x1b[0m");
+		color_reset();
 		free(rows);
 		return;
 	} else {
 		size_t j;
-		const char *fcol = frame_color_or_default(cfg);
+		const struct color *fcol = color_get(frame_color_or_default(cfg));
 		size_t soft_cap = 16, hard_cap = 16;
 		size_t soft_cnt = 0, hard_cnt = 0;
 		size_t *soft_idx = malloc(soft_cap * sizeof(*soft_idx));
 		size_t *hard_idx = malloc(hard_cap * sizeof(*hard_idx));
-		char **soft_plain = NULL, **hard_plain = NULL;
 		size_t *soft_len = NULL, *hard_len = NULL;
 		size_t inner_width = 0;
-		size_t top_title_len = strlen_safe(cfg->frame_title_soft);
-		size_t mid_title_len = strlen_safe(cfg->frame_title_hard);
+		size_t top_title_len = str_width(cfg->frame_title_soft);
+		size_t mid_title_len = str_width(cfg->frame_title_hard);
 		size_t rr, total_rows;
 		size_t box_rows;
 
@@ -711,14 +546,10 @@ void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
 			}
 		}
 
-		soft_plain = malloc(soft_cnt * sizeof(*soft_plain));
 		soft_len = malloc(soft_cnt * sizeof(*soft_len));
-		hard_plain = malloc(hard_cnt * sizeof(*hard_plain));
 		hard_len = malloc(hard_cnt * sizeof(*hard_len));
-		if ((soft_cnt && (!soft_plain || !soft_len)) || (hard_cnt && (!hard_plain || !hard_len))) {
-			free(soft_plain);
+		if ((soft_cnt && !soft_len) || (hard_cnt && !hard_len)) {
 			free(soft_len);
-			free(hard_plain);
 			free(hard_len);
 			free(soft_idx);
 			free(hard_idx);
@@ -727,14 +558,12 @@ void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
 		}
 
 		for (j = 0; j < soft_cnt; j++) {
-			soft_plain[j] = line_render_plain(&cfg->lines[soft_idx[j]]);
-			soft_len[j] = strlen_safe(soft_plain[j]);
+			soft_len[j] = line_plain_width(&cfg->lines[soft_idx[j]]);
 			if (soft_len[j] > inner_width)
 				inner_width = soft_len[j];
 		}
 		for (j = 0; j < hard_cnt; j++) {
-			hard_plain[j] = line_render_plain(&cfg->lines[hard_idx[j]]);
-			hard_len[j] = strlen_safe(hard_plain[j]);
+			hard_len[j] = line_plain_width(&cfg->lines[hard_idx[j]]);
 			if (hard_len[j] > inner_width)
 				inner_width = hard_len[j];
 		}
@@ -748,95 +577,83 @@ void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
 
 		for (rr = 0; rr < total_rows; rr++) {
 			if (rr < row_cnt) {
-				print_art_row_segments(art, rows[rr].cstart, rows[rr].end, latest_hex_color, sizeof(latest_hex_color));
+				print_art_row_segments(art, art_colors, rows[rr].cstart, rows[rr].end, &latest_color);
 				{
 					int padding = (int)max_art_len - (int)rows[rr].visual_len;
-					int p;
 
 					if (padding < 0)
 						padding = 0;
-					for (p = 0; p < padding + cfg->info_padding; ++p)
-						putchar(' ');
+					out_pad(padding + cfg->info_padding);
 				}
 			} else {
-				int p;
-				for (p = 0; p < (int)(max_art_len + cfg->info_padding); ++p)
-					putchar(' ');
+				out_pad((int)(max_art_len + cfg->info_padding));
 			}
 
 			if (rr == 0) {
-				print_titled_border_line("┌", "┐", cfg->frame_title_soft, inner_width + 2, fcol, latest_hex_color);
+				print_titled_border_line("┌", "┐", cfg->frame_title_soft, inner_width + 2, fcol, latest_color);
 			} else if (rr > 0 && rr <= soft_cnt) {
 				size_t li = rr - 1;
 				size_t pad = inner_width > soft_len[li] ? inner_width - soft_len[li] : 0;
 
-				hex_to_true_color(fcol);
-				printf("│ ");
-				hex_to_true_color(latest_hex_color);
-				print_info_line_idx(soft_idx[li], cfg, latest_hex_color);
-				hex_to_true_color(fcol);
-				{
-					size_t s;
-					for (s = 0; s < pad + 1; s++)
-						putchar(' ');
-				}
-				printf("│");
-				hex_to_true_color(latest_hex_color);
+				color_emit(fcol);
+				out_puts("│ ");
+				color_emit(latest_color);
+				print_info_line_idx(soft_idx[li], cfg, latest_color);
+				color_emit(fcol);
+				out_blank(pad + 1);
+				out_puts("│");
+				color_emit(latest_color);
 			} else if (rr == soft_cnt + 1) {
-				print_titled_border_line("├", "┤", cfg->frame_title_hard, inner_width + 2, fcol, latest_hex_color);
+				print_titled_border_line("├", "┤", cfg->frame_title_hard, inner_width + 2, fcol, latest_color);
 			} else if (rr > soft_cnt + 1 && rr <= soft_cnt + 1 + hard_cnt) {
 				size_t li = rr - (soft_cnt + 2);
 				size_t pad = inner_width > hard_len[li] ? inner_width - hard_len[li] : 0;
 
-				hex_to_true_color(fcol);
-				printf("│ ");
-				hex_to_true_color(latest_hex_color);
-				print_info_line_idx(hard_idx[li], cfg, latest_hex_color);
-				hex_to_true_color(fcol);
-				{
-					size_t s;
-					for (s = 0; s < pad + 1; s++)
-						putchar(' ');
-				}
-				printf("│");
-				hex_to_true_color(latest_hex_color);
+				color_emit(fcol);
+				out_puts("│ ");
+				color_emit(latest_color);
+				print_info_line_idx(hard_idx[li], cfg, latest_color);
+				color_emit(fcol);
+				out_blank(pad + 1);
+				out_puts("│");
+				color_emit(latest_color);
 			} else if (rr == box_rows - 1) {
-				hex_to_true_color(fcol);
-				printf("└");
+				color_emit(fcol);
+				out_puts("└");
 				print_repeat_utf8(fcol, NULL, "─", inner_width + 2);
-				printf("┘");
-				hex_to_true_color(latest_hex_color);
+				out_puts("┘");
+				color_emit(latest_color);
 			}
-			printf("\n");
+			out_putc('\n');
 		}
 
-		for (j = 0; j < soft_cnt; j++)
-			free(soft_plain[j]);
-		for (j = 0; j < hard_cnt; j++)
-			free(hard_plain[j]);
-		free(soft_plain);
 		free(soft_len);
-		free(hard_plain);
 		free(hard_len);
 		free(soft_idx);
 		free(hard_idx);
-		printf("\x1b[0m");
+		color_reset();
 		free(rows);
 		return;
 	}
 }
 
+void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg)
+{
+	const struct color **art_colors = art_colors_build(art);
 
-const char **auto_art_by_distro(char *distro)
+	render_configured(art, art_colors, cfg);
+	free(art_colors);
+	out_flush();
+}
+
+static const char **art_for_id(const char *id)
 {
 	char *distro_lower;
 	const char **ret;
 
-	if (distro == NULL)
-		return (const char **)tux_ascii;
-	distro_lower = str_tolower_dup(distro);
+	distro_lower = str_tolower_dup(id);
 	if (!distro_lower)
-		return (const char **)tux_ascii;
+		return NULL;
 
 	if (strcmp(distro_lower, "arch") == 0 || strcmp(distro_lower, "archlinux") == 0) {
 		ret = (const char **)arch_ascii_classic;
@@ -853,12 +670,33 @@ const char **auto_art_by_distro(char *distro)
 	} else if (strcmp(distro_lower, "debian") == 0) {
 		ret = (const char **)debian_ascii;
 	} else {
-		ret = (const char **)tux_ascii;
+		ret = NULL;
 	}
 	free(distro_lower);
 	return ret;
 }
 
+/* Unknown IDs fall back through ID_LIKE, e.g. rocky -> rhel, pop -> ubuntu -> debian. */
+const char **auto_art_by_distro(char *distro)
+{
+	const struct os_release *os;
+	const char **ret;
+	const char *like;
+	char word[64];
+
+	if (distro == NULL)
+		return (const char **)tux_ascii;
+	ret = art_for_id(distro);
+	if (ret)
+		return ret;
+	os = get_os_release();
+	like = os ? os->id_like : NULL;
+	while (os_release_next_like(&like, word, sizeof(word)))
+		if ((ret = art_for_id(word)) != NULL)
+			return ret;
+	return (const char **)tux_ascii;
+}
+
 
 
 
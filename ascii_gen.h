@@ -19,8 +19,6 @@ struct art_row {
 	size_t visual_len;
 };
 
-extern char last_hexcolor[16];
-
 
 /**
  * @brief Reads an ASCII art file and prints it to stdout as a C string array.
@@ -30,14 +28,36 @@ extern char last_hexcolor[16];
 
 
 int export_ascii_art(const char *filename);
-int hex_to_true_color(const char *hex_color);
-void print_info_line_idx(size_t idx, const struct cfetch_cfg *cfg, const char *restore_color);
-char *line_render_plain(const struct line_cfg *lc);
-void print_art_row_segments(const char *art[], int start, int end, char *latest_hex_color, size_t latest_hex_color_sz);
+void print_info_line_idx(size_t idx, const struct cfetch_cfg *cfg, const struct color *restore_color);
+
+/**
+ * @brief Display width of a line without colors, in terminal columns,
+ *        measured from its compiled tokens.
+ */
+size_t line_plain_width(const struct line_cfg *lc);
+
+/**
+ * @brief Tells whether any configured line uses a sampled placeholder
+ *        (%cpu_usage%, %disk_io%, %net_rx%, %net_tx%).
+ */
+int info_lines_need_sampler(const struct cfetch_cfg *cfg);
+
+/**
+ * @brief Resolves every non-sampled placeholder of the configured lines ahead of
+ *        rendering, so the probes run inside the sampling window.
+ */
+void prefetch_info_values(const struct cfetch_cfg *cfg);
+
+/**
+ * @brief Prints art rows start..end-1. colors holds the parsed color of each
+ *        '#' row (or is NULL); *latest is set to the last color applied.
+ */
+void print_art_row_segments(const char *art[], const struct color **colors, int start, int end,
+			    const struct color **latest);
 void build_art_rows(const char *art[], struct art_row **out_rows, size_t *out_count, size_t *out_max);
-void print_repeat_char(const char *color_hex, const char *restore_hex, char ch, size_t count);
-void print_repeat_utf8(const char *color_hex, const char *restore_hex, const char *glyph, size_t count);
-static void print_titled_border_line(const char *left_ch, const char *right_ch, const char *title, size_t inner_width, const char *frame_color, const char *restore_color);
+void print_repeat_char(const struct color *color, const struct color *restore, char ch, size_t count);
+void print_repeat_utf8(const struct color *color, const struct color *restore, const char *glyph, size_t count);
+static void print_titled_border_line(const char *left_ch, const char *right_ch, const char *title, size_t inner_width, const struct color *frame_color, const struct color *restore_color);
 int frame_kind(const struct cfetch_cfg *cfg);
 const char *frame_color_or_default(const struct cfetch_cfg *cfg);
 void print_ascii_configured(const char *art[], const struct cfetch_cfg *cfg);
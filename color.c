@@ -0,0 +1,258 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Files includes. */
+#include "color.h"
+#include "outbuf.h"
+#include "utils.h"
+
+/* Art colors that have always been drawn bold. */
+static const char *const bold_colors[] = { "989ef7", "FF0000", "7EB4DA", "5277C3" };
+
+struct color_entry {
+	char key[7];
+	struct color c;
+	struct color_entry *next;
+};
+
+static struct color_entry *colors;
+
+/* Output state: the color last written, and whether attributes are known to be default. */
+static const struct color *active;
+static int reset_known;
+
+#define SGR_RESET	"\x1b[0m"
+#define SGR_RESET_LEN	(sizeof(SGR_RESET) - 1)
+
+/* xterm's default palette for the 16 basic colors. */
+static const unsigned char ansi16[16][3] = {
+	{ 0, 0, 0 }, { 205, 0, 0 }, { 0, 205, 0 }, { 205, 205, 0 },
+	{ 0, 0, 238 }, { 205, 0, 205 }, { 0, 205, 205 }, { 229, 229, 229 },
+	{ 127, 127, 127 }, { 255, 0, 0 }, { 0, 255, 0 }, { 255, 255, 0 },
+	{ 92, 92, 255 }, { 255, 0, 255 }, { 0, 255, 255 }, { 255, 255, 255 },
+};
+
+/* Channel levels of the xterm-256 6x6x6 cube (indices 16-231). */
+static const unsigned char cube_levels[6] = { 0, 95, 135, 175, 215, 255 };
+
+static int depth = -1;
+static unsigned char cube_lut[256];	/* channel value -> nearest cube level */
+static unsigned char ansi16_lut[4096];	/* 4 bits per channel -> nearest basic color */
+
+static unsigned int dist2(unsigned int r, unsigned int g, unsigned int b,
+			  unsigned int r2, unsigned int g2, unsigned int b2)
+{
+	int dr = (int)r - (int)r2, dg = (int)g - (int)g2, db = (int)b - (int)b2;
+
+	return (unsigned int)(dr * dr + dg * dg + db * db);
+}
+
+static void color_tables_init(void)
+{
+	unsigned int v, i, k;
+
+	for (v = 0; v < 256; v++) {
+		for (i = 0; i < 5 && v > (cube_levels[i] + cube_levels[i + 1]) / 2u; i++)
+			;
+		cube_lut[v] = (unsigned char)i;
+	}
+	for (k = 0; k < 4096; k++) {
+		unsigned int r = ((k >> 8) << 4) | 8, g = (((k >> 4) & 15) << 4) | 8, b = ((k & 15) << 4) | 8;
+		unsigned int best = 0, bd = ~0u;
+
+		for (i = 0; i < 16; i++) {
+			unsigned int d = dist2(r, g, b, ansi16[i][0], ansi16[i][1], ansi16[i][2]);
+
+			if (d < bd) {
+				bd = d;
+				best = i;
+			}
+		}
+		ansi16_lut[k] = (unsigned char)best;
+	}
+}
+
+/*
+ * NO_COLOR or a non-terminal stdout means no escapes at all. Otherwise
+ * COLORTERM announces 24-bit support, TERM names 256-color (or "direct")
+ * terminals, and anything else known gets the 16 basic colors.
+ */
+enum color_depth color_depth(void)
+{
+	const char *nc, *ct, *term;
+
+	if (depth >= 0)
+		return (enum color_depth)depth;
+	nc = getenv("NO_COLOR");
+	ct = getenv("COLORTERM");
+	term = getenv("TERM");
+	if ((nc && *nc) || !isatty(STDOUT_FILENO) || !term || !*term || !strcmp(term, "dumb"))
+		depth = COLOR_DEPTH_NONE;
+	else if (ct && (!strcmp(ct, "truecolor") || !strcmp(ct, "24bit")))
+		depth = COLOR_DEPTH_TRUE;
+	else if (strstr(term, "-direct"))
+		depth = COLOR_DEPTH_TRUE;
+	else if (strstr(term, "256color"))
+		depth = COLOR_DEPTH_256;
+	else
+		depth = COLOR_DEPTH_16;
+	if (depth == COLOR_DEPTH_256 || depth == COLOR_DEPTH_16)
+		color_tables_init();
+	debug_log("color: depth %s", depth == COLOR_DEPTH_NONE ? "none" : depth == COLOR_DEPTH_16 ? "16" :
+		  depth == COLOR_DEPTH_256 ? "256" : "truecolor");
+	return (enum color_depth)depth;
+}
+
+/* Nearest xterm-256 index: the cube entry or the gray ramp (232-255), whichever is closer. */
+static unsigned int quantize_256(unsigned int r, unsigned int g, unsigned int b)
+{
+	unsigned int ci = cube_lut[r], cj = cube_lut[g], ck = cube_lut[b];
+	unsigned int avg = (r + g + b) / 3;
+	unsigned int gi = avg < 8 ? 0 : avg > 238 ? 23 : (avg - 8 + 5) / 10;
+	unsigned int gv = 8 + 10 * gi;
+
+	if (dist2(r, g, b, gv, gv, gv) <
+	    dist2(r, g, b, cube_levels[ci], cube_levels[cj], cube_levels[ck]))
+		return 232 + gi;
+	return 16 + 36 * ci + 6 * cj + ck;
+}
+
+static int hex_digit(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+		return ch - '0';
+	if (ch >= 'a' && ch <= 'f')
+		return ch - 'a' + 10;
+	if (ch >= 'A' && ch <= 'F')
+		return ch - 'A' + 10;
+	return -1;
+}
+
+/* Returns the six RGB digits of a color, or NULL. */
+static const char *color_digits(const char *hex)
+{
+	size_t n, i;
+
+	if (!hex)
+		return NULL;
+	if (*hex == '#')
+		hex++;
+	n = strlen(hex);
+	if (n != 6 && n != 8)
+		return NULL;
+	for (i = 0; i < n; i++)
+		if (hex_digit(hex[i]) < 0)
+			return NULL;
+	return hex;
+}
+
+int color_parse(const char *hex, struct color *out)
+{
+	const char *d = color_digits(hex);
+	unsigned int r, g, b;
+	size_t i;
+	int n;
+
+	if (!d)
+		return -1;
+	out->rgb = 0;
+	for (i = 0; i < 6; i++)
+		out->rgb = (out->rgb << 4) | (unsigned int)hex_digit(d[i]);
+	out->bold = 0;
+	for (i = 0; i < sizeof(bold_colors) / sizeof(bold_colors[0]); i++)
+		if (strncmp(d, bold_colors[i], 6) == 0)
+			out->bold = 1;
+	r = (out->rgb >> 16) & 0xFF;
+	g = (out->rgb >> 8) & 0xFF;
+	b = out->rgb & 0xFF;
+	switch (color_depth()) {
+	case COLOR_DEPTH_NONE:
+		out->sgr[0] = '\0';
+		out->sgr_len = out->fg_len = 0;
+		return 0;
+	case COLOR_DEPTH_16: {
+		unsigned int i = ansi16_lut[((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4)];
+
+		n = snprintf(out->sgr, sizeof(out->sgr), SGR_RESET "\x1b[%um", i < 8 ? 30 + i : 90 + i - 8);
+		break;
+	}
+	case COLOR_DEPTH_256:
+		n = snprintf(out->sgr, sizeof(out->sgr), SGR_RESET "\x1b[38;5;%um", quantize_256(r, g, b));
+		break;
+	default:
+		n = snprintf(out->sgr, sizeof(out->sgr), SGR_RESET "\x1b[38;2;%u;%u;%um", r, g, b);
+		break;
+	}
+	out->fg_len = n > 0 ? (size_t)n - SGR_RESET_LEN : 0;
+	if (out->bold)
+		n += snprintf(out->sgr + n, sizeof(out->sgr) - (size_t)n, "\x1b[1m");
+	out->sgr_len = n > 0 ? (size_t)n : 0;
+	return 0;
+}
+
+const struct color *color_get(const char *hex)
+{
+	const char *d = color_digits(hex);
+	struct color_entry *e;
+
+	if (!d)
+		return NULL;
+	for (e = colors; e; e = e->next)
+		if (strncmp(e->key, d, 6) == 0)
+			return &e->c;
+	e = malloc(sizeof(*e));
+	if (!e)
+		return NULL;
+	memcpy(e->key, d, 6);
+	e->key[6] = '\0';
+	color_parse(d, &e->c);
+	e->next = colors;
+	colors = e;
+	return &e->c;
+}
+
+void color_emit(const struct color *c)
+{
+	size_t n;
+
+	if (!c || !c->sgr_len)
+		return;
+	if (active && active->bold == c->bold && active->fg_len == c->fg_len &&
+	    memcmp(active->sgr, c->sgr, SGR_RESET_LEN + c->fg_len) == 0) {
+		out_saved(c->sgr_len);
+		return;
+	}
+	if (!active && !reset_known) {
+		out_write(c->sgr, c->sgr_len);
+	} else if (!active) {
+		out_write(c->sgr + SGR_RESET_LEN, c->sgr_len - SGR_RESET_LEN);
+		out_saved(SGR_RESET_LEN);
+	} else {
+		/* Only foreground and bold are ever set, so no reset is needed in between. */
+		n = c->fg_len;
+		out_write(c->sgr + SGR_RESET_LEN, c->fg_len);
+		if (c->bold && !active->bold) {
+			out_write("\x1b[1m", 4);
+			n += 4;
+		} else if (!c->bold && active->bold) {
+			out_write("\x1b[22m", 5);
+			n += 5;
+		}
+		if (n < c->sgr_len)
+			out_saved(c->sgr_len - n);
+	}
+	active = c;
+	reset_known = 0;
+}
+
+void color_reset(void)
+{
+	if (reset_known || color_depth() == COLOR_DEPTH_NONE)
+		return;
+	out_write(SGR_RESET, SGR_RESET_LEN);
+	active = NULL;
+	reset_known = 1;
+}
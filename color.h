@@ -0,0 +1,66 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stddef.h>
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  color.h
+ *
+ *    Description:  "#RRGGBB" colors parsed once into packed RGB with the escape
+ *                  sequence that selects them at the color depth of the terminal,
+ *                  so rendering only copies bytes.
+ *
+ * =====================================================================================
+ */
+
+enum color_depth {
+	COLOR_DEPTH_NONE,	/* not a terminal, NO_COLOR, or TERM=dumb: no escapes */
+	COLOR_DEPTH_16,
+	COLOR_DEPTH_256,
+	COLOR_DEPTH_TRUE,
+};
+
+struct color {
+	unsigned int rgb;	/* 0xRRGGBB */
+	int bold;
+	size_t sgr_len;
+	size_t fg_len;		/* the foreground part of sgr, after the reset */
+	char sgr[32];		/* reset, foreground, then bold if set; empty at COLOR_DEPTH_NONE */
+};
+
+/**
+ * @brief Detects what stdout can display from isatty(), NO_COLOR, COLORTERM
+ *        and TERM. Detected once per run.
+ */
+enum color_depth color_depth(void);
+
+/**
+ * @brief Parses "#RRGGBB" or "RRGGBB" (an alpha pair after it is ignored).
+ *        The escape sequence is quantized to the detected color depth.
+ * @return 0 on success, -1 if the text is not a hex color.
+ */
+int color_parse(const char *hex, struct color *out);
+
+/**
+ * @brief Parses a color once and keeps it for the rest of the run; the same
+ *        text always yields the same pointer.
+ * @return The parsed color, or NULL if the text is not a hex color.
+ */
+const struct color *color_get(const char *hex);
+
+/**
+ * @brief Switches the output to a color. The active color is tracked, so
+ *        nothing is written if it is already set, and only the foreground
+ *        and bold change are written when switching between two colors.
+ *        NULL (an invalid color) appends nothing.
+ */
+void color_emit(const struct color *c);
+
+/**
+ * @brief Returns the output to the terminal's default attributes.
+ */
+void color_reset(void);
+
+#endif // COLOR_H
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include <unistd.h>
 
@@ -47,6 +48,8 @@ void parse_custom_ascii_section(FILE *file) {
 
         if (start_quote && end_quote && start_quote != end_quote) {
             *end_quote = '\0';
+            if (start_quote[1] == '#' && !color_get(start_quote + 1))
+                fprintf(stderr, "cfetch: config: invalid color \"%s\" in custom_ascii\n", start_quote + 1);
             add_custom_ascii_line(start_quote + 1);
         }
     }
@@ -74,6 +77,10 @@ void cfg_init_defaults(struct cfetch_cfg *cfg)
 	cfg->frame_color = xstrdup("#cccccc");
 	cfg->frame_title_soft = xstrdup("Softwares");
 	cfg->frame_title_hard = xstrdup("Hardwares");
+	cfg->sample_window = 0;
+	cfg->cursor_forward = 1;
+	cfg->net_ignore = xstrdup("veth*,docker*,br-*,virbr*,vnet*,cni*,flannel*,cali*");
+	cfg->net_ignore_kinds = xstrdup("veth,bridge,tun,dummy,vxlan,macvtap,ipvlan");
 }
 
 void cfg_ensure_line(struct cfetch_cfg *cfg, size_t idx)
@@ -95,6 +102,8 @@ void cfg_ensure_line(struct cfetch_cfg *cfg, size_t idx)
 		n[i].forced = NULL;
 		n[i].forced_count = 0;
 		n[i].arrange_box = 0;
+		n[i].tokens = NULL;
+		n[i].tokens_count = 0;
 	}
 	cfg->lines = n;
 	cfg->lines_count = idx + 1;
@@ -111,6 +120,8 @@ void cfg_free(struct cfetch_cfg *cfg)
 	free(cfg->frame_color);
 	free(cfg->frame_title_soft);
 	free(cfg->frame_title_hard);
+	free(cfg->net_ignore);
+	free(cfg->net_ignore_kinds);
 	for (i = 0; i < cfg->lines_count; i++) {
 		free(cfg->lines[i].format);
 		free(cfg->lines[i].color);
@@ -121,6 +132,9 @@ void cfg_free(struct cfetch_cfg *cfg)
 			free(cfg->lines[i].forced[j].val);
 		}
 		free(cfg->lines[i].forced);
+		for (j = 0; j < cfg->lines[i].tokens_count; j++)
+			free(cfg->lines[i].tokens[j].ref.arg);
+		free(cfg->lines[i].tokens);
 	}
 	free(cfg->lines);
 
@@ -164,27 +178,6 @@ void line_force_set(struct line_cfg *lc, const char *key, const char *val)
 	lc->forced_count++;
 }
 
-char *line_force_get_dup(const struct line_cfg *lc, const char *key)
-{
-	size_t i;
-	char *k;
-	char *res = NULL;
-
-	if (!lc || !key)
-		return NULL;
-	k = str_tolower_dup(key);
-	if (!k)
-		return NULL;
-	for (i = 0; i < lc->forced_count; i++) {
-		if (strcmp(lc->forced[i].key, k) == 0) {
-			res = xstrdup(lc->forced[i].val ? lc->forced[i].val : "");
-			break;
-		}
-	}
-	free(k);
-	return res;
-}
-
 char *config_path(void)
 {
 	const char *xdg;
@@ -213,6 +206,143 @@ char *config_path(void)
 }
 
 
+/* Forced keys are stored lowercase; name is a span of the format. */
+static const char *line_force_find(const struct line_cfg *lc, const char *name, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < lc->forced_count; i++)
+		if (strlen(lc->forced[i].key) == len && strncasecmp(lc->forced[i].key, name, len) == 0)
+			return lc->forced[i].val ? lc->forced[i].val : "";
+	return NULL;
+}
+
+static struct fmt_token *line_token_add(struct line_cfg *lc, enum fmt_token_kind kind,
+					const char *text, size_t len)
+{
+	struct fmt_token *tmp;
+
+	tmp = realloc(lc->tokens, sizeof(*tmp) * (lc->tokens_count + 1));
+	if (!tmp)
+		return NULL;
+	lc->tokens = tmp;
+	tmp = &lc->tokens[lc->tokens_count++];
+	tmp->kind = kind;
+	tmp->text = text;
+	tmp->len = len;
+	tmp->width = kind == FMT_TEXT ? utf8_width(text, len) : 0;
+	tmp->color = NULL;
+	tmp->ref.probe = PROBE_NONE;
+	tmp->ref.arg = NULL;
+	return tmp;
+}
+
+/* Emits a color switch unless that color is already active. */
+static void line_token_color(struct line_cfg *lc, const struct color *color,
+			     const struct color **cur)
+{
+	struct fmt_token *t;
+
+	if (!color || color == *cur)
+		return;
+	t = line_token_add(lc, FMT_COLOR, NULL, 0);
+	if (t) {
+		t->color = color;
+		*cur = color;
+	}
+}
+
+static void line_token_text(struct line_cfg *lc, const char *text, size_t len,
+			    const struct color *col_lbl, const struct color **cur)
+{
+	line_token_color(lc, col_lbl, cur);
+	line_token_add(lc, FMT_TEXT, text, len);
+}
+
+/*
+ * Turns a format into literal spans, placeholders and color switches, so
+ * rendering and measuring never re-parse it. A forced value is bound here;
+ * otherwise the placeholder and its argument are resolved to a probe ID.
+ * Unknown placeholders keep PROBE_NONE and render empty. "%%" prints nothing
+ * and a trailing unmatched '%' is kept as text, as before.
+ */
+static void cfg_compile_line(struct cfetch_cfg *cfg, size_t idx)
+{
+	struct line_cfg *lc = &cfg->lines[idx];
+	const struct color *col_lbl = color_get(lc->label_color ? lc->label_color : cfg->default_label_color);
+	const struct color *col_data = color_get(lc->data_color ? lc->data_color : cfg->default_data_color);
+	const struct color *cur = NULL;
+	const char *p = lc->format;
+
+	if (lc->color) {
+		line_token_color(lc, color_get(lc->color), &cur);
+		col_lbl = col_data = NULL;
+	}
+	while (*p) {
+		const char *b = strchr(p, '%');
+		const char *e;
+		struct fmt_token *t;
+
+		if (!b) {
+			line_token_text(lc, p, strlen(p), col_lbl, &cur);
+			break;
+		}
+		if (b > p)
+			line_token_text(lc, p, (size_t)(b - p), col_lbl, &cur);
+		e = strchr(b + 1, '%');
+		if (!e) {
+			line_token_text(lc, b, strlen(b), col_lbl, &cur);
+			break;
+		}
+		p = e + 1;
+		if (e == b + 1)
+			continue;
+		line_token_color(lc, col_data, &cur);
+		t = line_token_add(lc, FMT_VALUE, line_force_find(lc, b + 1, (size_t)(e - b - 1)), 0);
+		if (t && !t->text && placeholder_parse(b + 1, (size_t)(e - b - 1), &t->ref) != 0)
+			debug_log("config: line %zu: unknown placeholder %%%.*s%%", idx,
+				  (int)(e - b - 1), b + 1);
+	}
+}
+
+static void cfg_check_color(const char *hex, const char *what, long idx)
+{
+	if (!hex || color_get(hex))
+		return;
+	if (idx < 0)
+		fprintf(stderr, "cfetch: config: invalid color \"%s\" for %s\n", hex, what);
+	else
+		fprintf(stderr, "cfetch: config: invalid color \"%s\" for line[%ld] %s\n", hex, idx, what);
+}
+
+/* Colors are parsed here once; a bad one is reported now rather than skipped at render. */
+static void cfg_check_colors(const struct cfetch_cfg *cfg)
+{
+	size_t i;
+
+	cfg_check_color(cfg->default_label_color, "default_label_color", -1);
+	cfg_check_color(cfg->default_data_color, "default_data_color", -1);
+	cfg_check_color(cfg->frame_color, "frame_color", -1);
+	for (i = 0; i < cfg->lines_count; i++) {
+		const struct line_cfg *lc = &cfg->lines[i];
+
+		if (!lc->present)
+			continue;
+		cfg_check_color(lc->color, "color", (long)i);
+		cfg_check_color(lc->label_color, "label_color", (long)i);
+		cfg_check_color(lc->data_color, "data_color", (long)i);
+	}
+}
+
+static void cfg_compile_lines(struct cfetch_cfg *cfg)
+{
+	size_t i;
+
+	for (i = 0; i < cfg->lines_count; i++)
+		if (cfg->lines[i].present && cfg->lines[i].format)
+			cfg_compile_line(cfg, i);
+}
+
 int cfg_load(struct cfetch_cfg *cfg)
 {
 	char *path;
@@ -328,6 +458,26 @@ int cfg_load(struct cfetch_cfg *cfg)
 					free(cfg->frame_title_hard);
 					cfg->frame_title_hard = xstrdup(val);
 				}
+			} else if (strncmp(s, "cursor_forward", 14) == 0) {
+				val = read_kv_value(s);
+				if (val)
+					cfg->cursor_forward = atoi(val);
+			} else if (strncmp(s, "sample_window", 13) == 0) {
+				val = read_kv_value(s);
+				if (val)
+					cfg->sample_window = atoi(val);
+			} else if (strncmp(s, "net_ignore_kinds", 16) == 0) {
+				val = read_kv_value(s);
+				if (val) {
+					free(cfg->net_ignore_kinds);
+					cfg->net_ignore_kinds = xstrdup(val);
+				}
+			} else if (strncmp(s, "net_ignore", 10) == 0) {
+				val = read_kv_value(s);
+				if (val) {
+					free(cfg->net_ignore);
+					cfg->net_ignore = xstrdup(val);
+				}
 			}
 			continue;
 		}
@@ -411,5 +561,7 @@ done_force:
 	}
 	free(line);
 	fclose(f);
+	cfg_check_colors(cfg);
+	cfg_compile_lines(cfg);
 	return 1;
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <stddef.h> 
 #include <stdio.h>
 
+#include "color.h"
+#include "fetch_sw.h"
+
 /*
  * =====================================================================================
  *
@@ -23,6 +26,22 @@ struct kv_pair {
 	char *val;
 };
 
+/* One step of a compiled line format; see cfg_load(). */
+enum fmt_token_kind {
+	FMT_TEXT,	/* literal span of the format */
+	FMT_VALUE,	/* placeholder: forced value, or probe when text is NULL */
+	FMT_COLOR,	/* switch to color */
+};
+
+struct fmt_token {
+	enum fmt_token_kind kind;
+	const char *text;	/* points into format or forced */
+	size_t len;		/* FMT_TEXT only */
+	size_t width;		/* FMT_TEXT only: display columns of text */
+	const struct color *color;	/* FMT_COLOR only */
+	struct placeholder_ref ref;
+};
+
 struct line_cfg {
 	int present;
 	char *format;
@@ -32,6 +51,8 @@ struct line_cfg {
 	struct kv_pair *forced;
 	size_t forced_count;
 	int arrange_box;
+	struct fmt_token *tokens;	/* format compiled at load, immutable afterwards */
+	size_t tokens_count;
 };
 
 struct cfetch_cfg {
@@ -45,6 +66,10 @@ struct cfetch_cfg {
 	char *frame_color;
 	char *frame_title_soft;
 	char *frame_title_hard;
+	int sample_window;
+	int cursor_forward;
+	char *net_ignore;
+	char *net_ignore_kinds;
 };
 
 
@@ -56,7 +81,8 @@ struct cfetch_cfg {
 void cfg_init_defaults(struct cfetch_cfg *cfg);
 
 /**
- * @brief Loads configuration from the default file path into the struct.
+ * @brief Loads configuration from the default file path into the struct and
+ *        compiles each line format into its token array.
  * @param cfg Pointer to the cfetch_cfg struct to fill.
  * @return 1 on success, 0 on failure (e.g., file not found).
  */
@@ -68,16 +94,6 @@ int cfg_load(struct cfetch_cfg *cfg);
  */
 void cfg_free(struct cfetch_cfg *cfg);
 
-/**
- * @brief Gets a forced (overridden) value for a placeholder in a specific line.
- *        Used by the display logic to check for overrides.
- * @param lc Pointer to the line_cfg struct.
- * @param key The name of the placeholder (e.g., "os").
- * @return A dynamically allocated string with the value, or NULL if not found.
- *         The caller is responsible for freeing the returned string.
- */
-char *line_force_get_dup(const struct line_cfg *lc, const char *key);
-
 typedef struct {
     char **lines;  
     int line_count;  
@@ -1,8 +1,9 @@
 #define _POSIX_C_SOURCE 200809L
-#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <glob.h>
 #include <ctype.h>
@@ -10,9 +11,19 @@
 #include <pwd.h>
 #include <sys/utsname.h>
 #include <time.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <dirent.h>
 #include <sys/statvfs.h>
+#include <pthread.h>
 
 #include "fetch_hw.h" 
+#include "utils.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define HAVE_CPUID 1
+#endif
 
 #if defined(__APPLE__)
 #include <sys/types.h>
@@ -60,27 +71,183 @@ char *get_monitor_info(void)
 	return res;
 }
 
-char *get_memory(void)
+enum meminfo_field {
+	MI_MEM_TOTAL,
+	MI_MEM_AVAILABLE,
+	MI_SWAP_TOTAL,
+	MI_SWAP_FREE,
+	MI_HUGE_TOTAL,
+	MI_HUGE_FREE,
+	MI_HUGE_SIZE,
+	MI_FIELDS
+};
+
+#define MI_BIT(f)	(1u << (f))
+
+static const struct {
+	const char *key;
+	size_t len;
+} meminfo_keys[MI_FIELDS] = {
+	[MI_MEM_TOTAL]		= { "MemTotal",		8 },
+	[MI_MEM_AVAILABLE]	= { "MemAvailable",	12 },
+	[MI_SWAP_TOTAL]		= { "SwapTotal",	9 },
+	[MI_SWAP_FREE]		= { "SwapFree",		8 },
+	[MI_HUGE_TOTAL]		= { "HugePages_Total",	15 },
+	[MI_HUGE_FREE]		= { "HugePages_Free",	14 },
+	[MI_HUGE_SIZE]		= { "Hugepagesize",	12 },
+};
+
+struct meminfo {
+	unsigned int have;
+	unsigned long long val[MI_FIELDS];	/* kB, or pages for HugePages_* */
+	unsigned long long cg_limit;		/* bytes, 0 when unlimited */
+	unsigned long long cg_current;		/* bytes */
+};
+
+/*
+ * One read of /proc/meminfo, one pass over it: each key is matched by length
+ * and bytes against the wanted entries of meminfo_keys, and the scan stops as
+ * soon as every wanted field has been seen.
+ */
+static void meminfo_parse(struct meminfo *mi, unsigned int want)
 {
-	const char *Gigabyte = "GB";
-	FILE *f = fopen("/proc/meminfo", "r");
-	if (!f) return NULL;
+	char buf[8192];
+	char *p, *end;
+	ssize_t n;
 
-	char line[256];
-	unsigned long mem_total_kb = 0;
-	unsigned long mem_available_kb = 0;
+	n = read_file_at(AT_FDCWD, "/proc/meminfo", buf, sizeof(buf));
+	if (n <= 0)
+		return;
+	end = buf + n;
+	for (p = buf; p < end && (mi->have & want) != want; ) {
+		char *colon = memchr(p, ':', (size_t)(end - p));
+		char *eol;
+		size_t klen;
+		int f;
 
-	while (fgets(line, sizeof(line), f)) {
-		if (sscanf(line, "MemTotal: %lu kB", &mem_total_kb) == 1) continue;
-		if (sscanf(line, "MemAvailable: %lu kB", &mem_available_kb) == 1) continue;
-		if (mem_total_kb && mem_available_kb) break;
+		if (!colon)
+			break;
+		klen = (size_t)(colon - p);
+		for (f = 0; f < MI_FIELDS; f++) {
+			if ((want & MI_BIT(f)) && meminfo_keys[f].len == klen &&
+			    memcmp(p, meminfo_keys[f].key, klen) == 0) {
+				mi->val[f] = strtoull(colon + 1, NULL, 10);
+				mi->have |= MI_BIT(f);
+				break;
+			}
+		}
+		eol = memchr(colon, '\n', (size_t)(end - colon));
+		if (!eol)
+			break;
+		p = eol + 1;
 	}
-	fclose(f);
+}
+
+/*
+ * Writes the cgroup v2 directory of this process (from the "0::" line of
+ * /proc/self/cgroup) into buf. Returns -1 on cgroup v1-only systems.
+ */
+int cgroup_v2_dir(char *buf, size_t sz)
+{
+	char cg[1024];
+	char *line, *save = NULL;
+
+	if (read_file_at(AT_FDCWD, "/proc/self/cgroup", cg, sizeof(cg)) <= 0)
+		return -1;
+	for (line = strtok_r(cg, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		if (strncmp(line, "0::", 3) == 0) {
+			snprintf(buf, sz, "/sys/fs/cgroup%s", strcmp(line + 3, "/") ? line + 3 : "");
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*
+ * The effective limit is the smallest memory.max on the way up to the root,
+ * "max" meaning unlimited. The root itself is read too: with a private
+ * cgroup namespace a container sees its own cgroup as "0::/", mounted at
+ * /sys/fs/cgroup. The host's root cgroup has neither file.
+ */
+static void meminfo_cgroup(struct meminfo *mi)
+{
+	char dir[1100];
+	char path[1200];
+	char val[32];
+	size_t root_len = strlen("/sys/fs/cgroup");
+
+	if (cgroup_v2_dir(dir, sizeof(dir)) != 0 || strlen(dir) < root_len)
+		return;
+	snprintf(path, sizeof(path), "%s/memory.current", dir);
+	mi->cg_current = (unsigned long long)read_long_at(AT_FDCWD, path, 0);
+	for (;;) {
+		char *slash;
+
+		snprintf(path, sizeof(path), "%s/memory.max", dir);
+		if (read_file_at(AT_FDCWD, path, val, sizeof(val)) > 0 && isdigit((unsigned char)val[0])) {
+			unsigned long long lim = strtoull(val, NULL, 10);
+
+			if (mi->cg_limit == 0 || lim < mi->cg_limit)
+				mi->cg_limit = lim;
+		}
+		if (strlen(dir) <= root_len)
+			break;
+		slash = strrchr(dir, '/');
+		if (!slash)
+			break;
+		*slash = '\0';
+	}
+}
+
+static const struct meminfo *meminfo_get(unsigned int want)
+{
+	static struct meminfo mi;
+	static int cg_done;
+
+	if ((mi.have & want) != want)
+		meminfo_parse(&mi, want | mi.have);
+	if (!cg_done && (want & (MI_BIT(MI_MEM_TOTAL) | MI_BIT(MI_MEM_AVAILABLE)))) {
+		meminfo_cgroup(&mi);
+		cg_done = 1;
+	}
+	return &mi;
+}
+
+/*
+ * Used and total RAM in kB. Inside a cgroup whose memory.max is below the
+ * machine's RAM the limit becomes the total and memory.current the usage.
+ */
+int get_ram_usage(unsigned long long *used_kb, unsigned long long *total_kb)
+{
+	const struct meminfo *mi = meminfo_get(MI_BIT(MI_MEM_TOTAL) | MI_BIT(MI_MEM_AVAILABLE));
+	unsigned long long total = mi->val[MI_MEM_TOTAL];
+	unsigned long long used = total - mi->val[MI_MEM_AVAILABLE];
 
-	if (mem_total_kb == 0) return NULL;
+	if (total == 0)
+		return -1;
+	if (mi->cg_limit && mi->cg_limit / 1024 < total) {
+		total = mi->cg_limit / 1024;
+		if (mi->cg_current)
+			used = mi->cg_current / 1024;
+		if (used > total)
+			used = total;
+		debug_log("mem: clamped to cgroup memory.max (%llu kB)", total);
+	}
+	*used_kb = used;
+	*total_kb = total;
+	return 0;
+}
+
+char *get_memory(void)
+{
+	const char *Gigabyte = "GB";
+	unsigned long long used_kb, total_kb;
+
+	if (get_ram_usage(&used_kb, &total_kb) != 0)
+		return NULL;
 
-	double total_gb = mem_total_kb / 1024.0 / 1024.0;
-	double used_gb = (mem_total_kb - mem_available_kb) / 1024.0 / 1024.0;
+	double total_gb = total_kb / 1024.0 / 1024.0;
+	double used_gb = used_kb / 1024.0 / 1024.0;
 
 	char *result = malloc(32);
 	if (!result) return NULL;
@@ -88,6 +255,150 @@ char *get_memory(void)
 	return result;
 }
 
+char *get_ram_percent(void)
+{
+	unsigned long long used_kb, total_kb;
+	char buf[16];
+
+	if (get_ram_usage(&used_kb, &total_kb) != 0)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%.0f%%", 100.0 * (double)used_kb / (double)total_kb);
+	return xstrdup(buf);
+}
+
+char *get_swap_str(void)
+{
+	const struct meminfo *mi = meminfo_get(MI_BIT(MI_SWAP_TOTAL) | MI_BIT(MI_SWAP_FREE));
+	unsigned long long total = mi->val[MI_SWAP_TOTAL];
+	char buf[32];
+
+	if (total == 0)
+		return xstrdup("none");
+	snprintf(buf, sizeof(buf), "%.1f/%.1f GB",
+		 (total - mi->val[MI_SWAP_FREE]) / 1024.0 / 1024.0, total / 1024.0 / 1024.0);
+	return xstrdup(buf);
+}
+
+char *get_hugepages_str(void)
+{
+	const struct meminfo *mi = meminfo_get(MI_BIT(MI_HUGE_TOTAL) | MI_BIT(MI_HUGE_FREE) |
+					       MI_BIT(MI_HUGE_SIZE));
+	unsigned long long total = mi->val[MI_HUGE_TOTAL];
+	unsigned long long size_kb = mi->val[MI_HUGE_SIZE];
+	char buf[64];
+
+	if (total == 0)
+		return xstrdup("none");
+	if (size_kb >= 1024 * 1024)
+		snprintf(buf, sizeof(buf), "%llu/%llu x %lluG", total - mi->val[MI_HUGE_FREE], total,
+			 size_kb / (1024 * 1024));
+	else
+		snprintf(buf, sizeof(buf), "%llu/%llu x %lluM", total - mi->val[MI_HUGE_FREE], total,
+			 size_kb / 1024);
+	return xstrdup(buf);
+}
+
+/* Sums mm_stat over every zram device: original vs. compressed size. */
+char *get_zram_str(void)
+{
+	DIR *d;
+	struct dirent *de;
+	unsigned long long orig = 0, compr = 0, disk = 0;
+	int dfd, found = 0;
+	char buf[64];
+
+	d = opendir("/sys/block");
+	if (!d)
+		return xstrdup("none");
+	dfd = dirfd(d);
+	while ((de = readdir(d)) != NULL) {
+		char path[300];
+		char stat[256];
+		unsigned long long o, c;
+
+		if (strncmp(de->d_name, "zram", 4) != 0)
+			continue;
+		snprintf(path, sizeof(path), "%s/disksize", de->d_name);
+		disk += (unsigned long long)read_long_at(dfd, path, 0);
+		snprintf(path, sizeof(path), "%s/mm_stat", de->d_name);
+		if (read_file_at(dfd, path, stat, sizeof(stat)) > 0 &&
+		    sscanf(stat, "%llu %llu", &o, &c) == 2) {
+			orig += o;
+			compr += c;
+		}
+		found = 1;
+	}
+	closedir(d);
+	if (!found || disk == 0)
+		return xstrdup("none");
+	snprintf(buf, sizeof(buf), "%.1f/%.1f GB", orig / 1073741824.0, disk / 1073741824.0);
+	if (compr > 0) {
+		size_t len = strlen(buf);
+
+		snprintf(buf + len, sizeof(buf) - len, " (%.1fx)", (double)orig / (double)compr);
+	}
+	return xstrdup(buf);
+}
+
+static const char *const psi_names[PSI_RESOURCES] = {
+	[PSI_CPU]	= "cpu",
+	[PSI_MEMORY]	= "memory",
+	[PSI_IO]	= "io",
+};
+
+/*
+ * Inside a cgroup the cgroup's own <res>.pressure is used; the root cgroup
+ * has none, so it and cgroup v1 hosts fall back to /proc/pressure/<res>.
+ */
+static const char *psi_path(enum psi_resource res)
+{
+	static char paths[PSI_RESOURCES][1200];
+	static int resolved;
+
+	if (!resolved) {
+		char dir[1100];
+		int in_cg = cgroup_v2_dir(dir, sizeof(dir)) == 0;
+		int r;
+
+		for (r = 0; r < PSI_RESOURCES; r++) {
+			if (in_cg) {
+				snprintf(paths[r], sizeof(paths[r]), "%s/%s.pressure", dir, psi_names[r]);
+				if (access(paths[r], R_OK) == 0)
+					continue;
+			}
+			snprintf(paths[r], sizeof(paths[r]), "/proc/pressure/%s", psi_names[r]);
+		}
+		resolved = 1;
+	}
+	return paths[res];
+}
+
+int psi_read(enum psi_resource res, struct psi_stat *st)
+{
+	char buf[256];
+	const char *p;
+
+	if (res < 0 || res >= PSI_RESOURCES ||
+	    read_file_at(AT_FDCWD, psi_path(res), buf, sizeof(buf)) <= 0)
+		return -1;
+	/* The "some" line comes first; stop parsing at the end of it. */
+	if (strncmp(buf, "some ", 5) != 0)
+		return -1;
+	p = strchr(buf, '\n');
+	if (p)
+		buf[p - buf] = '\0';
+	if (!(p = strstr(buf, "avg10=")))
+		return -1;
+	st->avg10 = strtod(p + 6, NULL);
+	if (!(p = strstr(buf, "avg60=")))
+		return -1;
+	st->avg60 = strtod(p + 6, NULL);
+	if (!(p = strstr(buf, "total=")))
+		return -1;
+	st->total = strtoull(p + 6, NULL, 10);
+	return 0;
+}
+
 char* get_gpu_name(void)
 {
 	char buffer[256];
@@ -159,46 +470,496 @@ char* get_gpu_name(void)
 	return gpu_name;
 }
 
-char *get_motherboard(void)
+/*
+ * SMBIOS. /sys/firmware/dmi/tables/DMI holds the raw structure table and is
+ * read once; each structure is a formatted area followed by its string set,
+ * which ends with a double NUL. Without read access to it (it is root-only on
+ * most distributions) the world-readable /sys/class/dmi/id attributes are used
+ * and DIMM details are unavailable.
+ */
+#define DMI_TABLE	"/sys/firmware/dmi/tables/DMI"
+#define DMI_ID_DIR	"/sys/class/dmi/id"
+#define DMI_MAX_DIMMS	32
+
+struct dmi_dimm {
+	unsigned long size_mb;
+	unsigned int speed;
+	unsigned char type;
+};
+
+struct dmi_info {
+	char bios_vendor[64];
+	char bios_version[64];
+	char bios_date[32];
+	char sys_vendor[64];
+	char product_name[64];
+	char product_serial[64];
+	char board_vendor[64];
+	char board_name[64];
+	char chassis_serial[64];
+	int chassis_type;
+	int from_table;
+	size_t dimm_count;
+	struct dmi_dimm dimms[DMI_MAX_DIMMS];
+};
+
+static const char *const chassis_types[] = {
+	NULL, "Other", "Unknown", "Desktop", "Low Profile Desktop", "Pizza Box",
+	"Mini Tower", "Tower", "Portable", "Laptop", "Notebook", "Hand Held",
+	"Docking Station", "All in One", "Sub Notebook", "Space-saving", "Lunch Box",
+	"Main Server Chassis", "Expansion Chassis", "SubChassis", "Bus Expansion Chassis",
+	"Peripheral Chassis", "RAID Chassis", "Rack Mount Chassis", "Sealed-case PC",
+	"Multi-system Chassis", "Compact PCI", "Advanced TCA", "Blade", "Blade Enclosure",
+	"Tablet", "Convertible", "Detachable", "IoT Gateway", "Embedded PC", "Mini PC",
+	"Stick PC",
+};
+
+static const char *dimm_type_name(unsigned char type)
 {
-	const char *vendor_file = "/sys/class/dmi/id/board_vendor";
-	const char *name_file   = "/sys/class/dmi/id/board_name";
+	switch (type) {
+	case 0x0f: return "SDRAM";
+	case 0x12: return "DDR";
+	case 0x13: return "DDR2";
+	case 0x18: return "DDR3";
+	case 0x1a: return "DDR4";
+	case 0x1b: return "LPDDR";
+	case 0x1c: return "LPDDR2";
+	case 0x1d: return "LPDDR3";
+	case 0x1e: return "LPDDR4";
+	case 0x22: return "DDR5";
+	case 0x23: return "LPDDR5";
+	default:   return NULL;
+	}
+}
 
-	char buffer[256];
-	char vendor[64];
-	FILE *f;
-	char *model;
+/* Vendors leave these in fields they did not fill in. */
+static int dmi_placeholder(const char *s)
+{
+	static const char *const junk[] = {
+		"To Be Filled By O.E.M.", "To be filled by O.E.M.", "Default string",
+		"Not Specified", "Not Applicable", "None", "System Serial Number",
+		"Chassis Serial Number", "0123456789", NULL
+	};
+	int i;
+
+	if (!*s)
+		return 1;
+	for (i = 0; junk[i]; i++)
+		if (!strcmp(s, junk[i]))
+			return 1;
+	return 0;
+}
+
+static void dmi_copy(char *dst, size_t size, const char *src)
+{
+	size_t n = strlen(src);
+
+	while (n > 0 && isspace((unsigned char)src[n - 1]))
+		n--;
+	while (n > 0 && isspace((unsigned char)*src)) {
+		src++;
+		n--;
+	}
+	snprintf(dst, size, "%.*s", (int)n, src);
+}
+
+/* String number idx (1-based) of the structure whose strings start at strs. */
+static const char *dmi_string(const unsigned char *strs, const unsigned char *end, unsigned char idx)
+{
+	const char *p = (const char *)strs;
+
+	if (idx == 0)
+		return "";
+	while (--idx > 0 && (const unsigned char *)p < end && *p)
+		p += strlen(p) + 1;
+	return ((const unsigned char *)p < end) ? p : "";
+}
+
+static unsigned int dmi_word(const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+static unsigned long dmi_dword(const unsigned char *p)
+{
+	return (unsigned long)dmi_word(p) | ((unsigned long)dmi_word(p + 2) << 16);
+}
+
+static void dmi_table_walk(struct dmi_info *di, const unsigned char *p, size_t len)
+{
+	const unsigned char *end = p + len;
+
+	while (p + 4 <= end) {
+		unsigned char type = p[0], flen = p[1];
+		const unsigned char *strs = p + flen, *next;
+
+		if (flen < 4 || strs > end)
+			break;
+		/* The string set ends at the first double NUL. */
+		for (next = strs; next + 1 < end && (next[0] || next[1]); next++)
+			;
+		next += 2;
+
+#define DMI_STR(off, field) \
+	if (flen > (off)) dmi_copy(di->field, sizeof(di->field), dmi_string(strs, end, p[off]))
+
+		if (type == 0) {
+			DMI_STR(0x04, bios_vendor);
+			DMI_STR(0x05, bios_version);
+			DMI_STR(0x08, bios_date);
+		} else if (type == 1) {
+			DMI_STR(0x04, sys_vendor);
+			DMI_STR(0x05, product_name);
+			DMI_STR(0x07, product_serial);
+		} else if (type == 2 && !di->board_vendor[0]) {
+			DMI_STR(0x04, board_vendor);
+			DMI_STR(0x05, board_name);
+		} else if (type == 3 && !di->chassis_type) {
+			if (flen > 0x05)
+				di->chassis_type = p[0x05] & 0x7f;
+			DMI_STR(0x07, chassis_serial);
+		} else if (type == 17 && flen > 0x15 && di->dimm_count < DMI_MAX_DIMMS) {
+			unsigned int size = dmi_word(p + 0x0c);
+			struct dmi_dimm *dm = &di->dimms[di->dimm_count];
+
+			/* 0 is an empty slot, 0xffff unknown; 0x7fff defers to the extended size. */
+			if (size != 0 && size != 0xffff) {
+				if (size == 0x7fff && flen > 0x1f)
+					dm->size_mb = dmi_dword(p + 0x1c) & 0x7fffffff;
+				else if (size & 0x8000)
+					dm->size_mb = (size & 0x7fff) / 1024;
+				else
+					dm->size_mb = size;
+				dm->type = p[0x12];
+				dm->speed = (flen > 0x21 && dmi_word(p + 0x20)) ? dmi_word(p + 0x20)
+										: dmi_word(p + 0x15);
+				di->dimm_count++;
+			}
+		}
+#undef DMI_STR
+		if (type == 127)
+			break;
+		p = next;
+	}
+}
+
+static void dmi_sysfs(struct dmi_info *di)
+{
+	static const struct {
+		const char *file;
+		size_t off;
+		size_t size;
+	} attrs[] = {
+#define DMI_ATTR(f) { #f, offsetof(struct dmi_info, f), sizeof(((struct dmi_info *)0)->f) }
+		DMI_ATTR(bios_vendor), DMI_ATTR(bios_version), DMI_ATTR(bios_date),
+		DMI_ATTR(sys_vendor), DMI_ATTR(product_name), DMI_ATTR(product_serial),
+		DMI_ATTR(board_vendor), DMI_ATTR(board_name), DMI_ATTR(chassis_serial),
+#undef DMI_ATTR
+	};
+	char buf[128];
+	size_t i;
+	int dfd;
+
+	dfd = open(DMI_ID_DIR, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dfd < 0)
+		return;
+	for (i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++)
+		if (read_file_at(dfd, attrs[i].file, buf, sizeof(buf)) > 0)
+			dmi_copy((char *)di + attrs[i].off, attrs[i].size, buf);
+	di->chassis_type = (int)read_long_at(dfd, "chassis_type", 0);
+	close(dfd);
+}
+
+static const struct dmi_info *dmi_get(void)
+{
+	static struct dmi_info di;
+	static int probed;
+	unsigned char *table;
 	size_t len;
-	char *result;
-	char *end;
 
-	f = fopen(vendor_file, "r");
-	if (!f) return NULL;
-	if (!fgets(buffer, sizeof(buffer), f)) { fclose(f); return NULL; }
-	fclose(f);
-	buffer[strcspn(buffer, "\n")] = 0;
-	sscanf(buffer, "%63s", vendor);
+	if (probed)
+		return &di;
+	probed = 1;
+	table = (unsigned char *)read_file_alloc(DMI_TABLE, &len);
+	if (table && len > 0) {
+		dmi_table_walk(&di, table, len);
+		di.from_table = 1;
+	} else {
+		dmi_sysfs(&di);
+	}
+	free(table);
+	debug_log("dmi: %s, %zu DIMMs", di.from_table ? "SMBIOS table" : "sysfs attributes",
+		  di.dimm_count);
+	return &di;
+}
 
-	f = fopen(name_file, "r");
-	if (!f) return NULL;
-	if (!fgets(buffer, sizeof(buffer), f)) { fclose(f); return NULL; }
-	fclose(f);
-	buffer[strcspn(buffer, "\n")] = 0;
+char *get_motherboard(void)
+{
+	const struct dmi_info *di = dmi_get();
+	char buf[160];
+
+	if (!di->board_vendor[0] && !di->board_name[0])
+		return NULL;
+	if (!di->board_name[0])
+		return xstrdup(di->board_vendor);
+	if (!di->board_vendor[0])
+		return xstrdup(di->board_name);
+	snprintf(buf, sizeof(buf), "%s %s", di->board_vendor, di->board_name);
+	return xstrdup(buf);
+}
 
-	model = buffer;
-	while (*model && isspace((unsigned char)*model)) model++;
-	len = strlen(model);
-	if (len == 0)
-		return xstrdup(vendor);
-	end = model + len - 1;
-	while (end > model && isspace((unsigned char)*end)) *end-- = '\0';
+char *get_bios_str(void)
+{
+	const struct dmi_info *di = dmi_get();
+	char buf[192];
 
-	result = malloc(strlen(vendor) + 1 + strlen(model) + 1);
-	if (!result) return NULL;
-	sprintf(result, "%s %s", vendor, model);
-	return result;
+	if (!di->bios_version[0])
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%s%s%s", di->bios_vendor[0] ? di->bios_vendor : "",
+		 di->bios_vendor[0] ? " " : "", di->bios_version);
+	if (di->bios_date[0]) {
+		size_t len = strlen(buf);
+
+		snprintf(buf + len, sizeof(buf) - len, " (%s)", di->bios_date);
+	}
+	return xstrdup(buf);
+}
+
+char *get_chassis_str(void)
+{
+	const struct dmi_info *di = dmi_get();
+	const char *type = NULL;
+	const char *serial = NULL;
+	char buf[128];
+
+	if (di->chassis_type > 0 &&
+	    (size_t)di->chassis_type < sizeof(chassis_types) / sizeof(chassis_types[0]))
+		type = chassis_types[di->chassis_type];
+	if (!dmi_placeholder(di->chassis_serial))
+		serial = di->chassis_serial;
+	else if (!dmi_placeholder(di->product_serial))
+		serial = di->product_serial;
+	if (!type && !serial)
+		return xstrdup("unknown");
+	if (!serial)
+		return xstrdup(type);
+	snprintf(buf, sizeof(buf), "%s, S/N %s", type ? type : "Unknown", serial);
+	return xstrdup(buf);
+}
+
+/* Identical modules are grouped: "2x 16 GB DDR4 @ 3200 MT/s, 1x 8 GB DDR4 @ 2666 MT/s". */
+char *get_dimms_str(void)
+{
+	const struct dmi_info *di = dmi_get();
+	char buf[512];
+	size_t i, j, len = 0;
+	int done[DMI_MAX_DIMMS] = { 0 };
+
+	if (di->dimm_count == 0)
+		return xstrdup(di->from_table ? "none" : "unknown");
+	buf[0] = '\0';
+	for (i = 0; i < di->dimm_count && len < sizeof(buf); i++) {
+		const struct dmi_dimm *a = &di->dimms[i];
+		const char *tname = dimm_type_name(a->type);
+		int count = 0;
+		char size[32];
+
+		if (done[i])
+			continue;
+		for (j = i; j < di->dimm_count; j++) {
+			const struct dmi_dimm *b = &di->dimms[j];
+
+			if (!done[j] && b->size_mb == a->size_mb && b->type == a->type &&
+			    b->speed == a->speed) {
+				done[j] = 1;
+				count++;
+			}
+		}
+		if (a->size_mb >= 1024 && a->size_mb % 1024 == 0)
+			snprintf(size, sizeof(size), "%lu GB", a->size_mb / 1024);
+		else
+			snprintf(size, sizeof(size), "%lu MB", a->size_mb);
+		len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s%dx %s%s%s", len ? ", " : "",
+					count, size, tname ? " " : "", tname ? tname : "");
+		if (a->speed && len < sizeof(buf))
+			len += (size_t)snprintf(buf + len, sizeof(buf) - len, " @ %u MT/s", a->speed);
+	}
+	return xstrdup(buf);
+}
+
+
+/*
+ * Virtualization, container and init detection. Every signal is a CPUID
+ * instruction or a single small read; each answer is settled by the first
+ * conclusive signal and nothing is ever executed.
+ */
+static const struct {
+	const char *match;
+	const char *name;
+} hypervisor_sigs[] = {
+	{ "KVMKVMKVM",		"KVM" },
+	{ "TCGTCGTCGTCG",	"QEMU" },
+	{ "Microsoft Hv",	"Hyper-V" },
+	{ "VMwareVMware",	"VMware" },
+	{ "XenVMMXenVMM",	"Xen" },
+	{ "VBoxVBoxVBox",	"VirtualBox" },
+	{ " lrpepyh  vr",	"Parallels" },
+	{ "bhyve bhyve ",	"bhyve" },
+	{ "ACRNACRNACRN",	"ACRN" },
+	{ "QNXQVMBSQG",		"QNX" },
+	{ "Linux KVM Hv",	"KVM" },
+	{ NULL,			NULL }
+};
+
+/* Matched against the SMBIOS system manufacturer and product name. */
+static const struct {
+	const char *match;
+	const char *name;
+} dmi_virt_sigs[] = {
+	{ "QEMU",		"QEMU" },
+	{ "KVM",		"KVM" },
+	{ "VMware",		"VMware" },
+	{ "innotek GmbH",	"VirtualBox" },
+	{ "VirtualBox",		"VirtualBox" },
+	{ "Xen",		"Xen" },
+	{ "Parallels",		"Parallels" },
+	{ "BHYVE",		"bhyve" },
+	{ "Amazon EC2",		"Amazon EC2" },
+	{ "Google Compute Engine", "Google Compute Engine" },
+	{ "Virtual Machine",	"Hyper-V" },
+	{ NULL,			NULL }
+};
+
+static const char *virt_probe(void)
+{
+	static const char *virt;
+	const struct dmi_info *di;
+	int hypervisor_bit = -1;
+	int i;
+
+	if (virt)
+		return virt;
+#ifdef HAVE_CPUID
+	{
+		unsigned int a, b, c, d;
+		char sig[13];
+
+		if (__get_cpuid(1, &a, &b, &c, &d)) {
+			hypervisor_bit = (c >> 31) & 1;
+			if (hypervisor_bit) {
+				__cpuid(0x40000000, a, b, c, d);
+				memcpy(sig, &b, 4);
+				memcpy(sig + 4, &c, 4);
+				memcpy(sig + 8, &d, 4);
+				sig[12] = '\0';
+				for (i = 0; hypervisor_sigs[i].match; i++) {
+					if (!strncmp(sig, hypervisor_sigs[i].match,
+						     strlen(hypervisor_sigs[i].match))) {
+						debug_log("virt: cpuid signature \"%s\"", sig);
+						return virt = hypervisor_sigs[i].name;
+					}
+				}
+			}
+		}
+	}
+#endif
+	di = dmi_get();
+	for (i = 0; dmi_virt_sigs[i].match; i++)
+		if (strstr(di->sys_vendor, dmi_virt_sigs[i].match) ||
+		    strstr(di->product_name, dmi_virt_sigs[i].match))
+			return virt = dmi_virt_sigs[i].name;
+	/* A hypervisor bit with an unknown signature is still a VM. */
+	return virt = hypervisor_bit == 1 ? "unknown hypervisor" : "none";
+}
+
+static const char *container_probe(void)
+{
+	static const char *container;
+	static const struct {
+		const char *match;
+		const char *name;
+	} cgroup_sigs[] = {
+		{ "kubepods",	"Kubernetes" },
+		{ "libpod",	"Podman" },
+		{ "docker",	"Docker" },
+		{ "/lxc",	"LXC" },
+		{ ".lxc",	"LXC" },
+		{ NULL,		NULL }
+	};
+	char buf[2048];
+	int i;
+
+	if (container)
+		return container;
+	if (read_file_at(AT_FDCWD, "/proc/1/cgroup", buf, sizeof(buf)) > 0)
+		for (i = 0; cgroup_sigs[i].match; i++)
+			if (strstr(buf, cgroup_sigs[i].match))
+				return container = cgroup_sigs[i].name;
+	/* cgroup namespaces hide the path above, so look for the runtimes' marker files. */
+	if (access("/.dockerenv", F_OK) == 0)
+		return container = "Docker";
+	if (access("/run/.containerenv", F_OK) == 0)
+		return container = "Podman";
+	if (read_file_at(AT_FDCWD, "/run/systemd/container", buf, 64) > 0)
+		return container = strcmp(buf, "lxc") == 0 ? "LXC" :
+				   strcmp(buf, "systemd-nspawn") == 0 ? "systemd-nspawn" : "container";
+	return container = "none";
+}
+
+static const char *init_probe(void)
+{
+	static char init[32];
+	static const struct {
+		const char *comm;
+		const char *name;
+	} inits[] = {
+		{ "systemd",	 "systemd" },
+		{ "openrc-init", "OpenRC" },
+		{ "runit",	 "runit" },
+		{ "s6-svscan",	 "s6" },
+		{ "dinit",	 "dinit" },
+		{ "shepherd",	 "Shepherd" },
+		{ "init",	 "SysV init" },
+		{ "tini",	 "tini" },
+		{ "docker-init", "tini" },
+		{ "dumb-init",	 "dumb-init" },
+		{ "catatonit",	 "catatonit" },
+		{ NULL,		 NULL }
+	};
+	char comm[32];
+	int i;
+
+	if (init[0])
+		return init;
+	if (read_file_at(AT_FDCWD, "/proc/1/comm", comm, sizeof(comm)) <= 0) {
+		snprintf(init, sizeof(init), "unknown");
+		return init;
+	}
+	for (i = 0; inits[i].comm; i++) {
+		if (!strcmp(comm, inits[i].comm)) {
+			snprintf(init, sizeof(init), "%s", inits[i].name);
+			return init;
+		}
+	}
+	/* Containers often run the application itself as PID 1. */
+	snprintf(init, sizeof(init), "%s", comm);
+	return init;
+}
+
+char *get_virt_str(void)
+{
+	return xstrdup(virt_probe());
+}
+
+char *get_container_str(void)
+{
+	return xstrdup(container_probe());
 }
 
+char *get_init_str(void)
+{
+	return xstrdup(init_probe());
+}
 
 
 char *get_disk_info(void)
@@ -222,28 +983,1387 @@ char *get_disk_info(void)
 	return res;
 }
 
-char* get_cpu_name(void)
+#ifdef HAVE_CPUID
+/*
+ * Reads the brand string from CPUID leaves 0x80000002-0x80000004 and squeezes
+ * the padding spaces some vendors put in it.
+ */
+static char *cpuid_brand_string(void)
 {
-	FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
-	char line[256];
-	char* cpu_name = NULL;
-	char* colon;
+	unsigned int regs[12];
+	unsigned int a, b, c, d, leaf;
+	char brand[49];
+	char out[49];
+	char *src;
+	size_t n = 0;
 
-	if (cpuinfo == NULL)
+	if (!__get_cpuid(0x80000000, &a, &b, &c, &d) || a < 0x80000004)
 		return NULL;
+	for (leaf = 0; leaf < 3; leaf++)
+		__get_cpuid(0x80000002 + leaf, &regs[leaf * 4], &regs[leaf * 4 + 1],
+			    &regs[leaf * 4 + 2], &regs[leaf * 4 + 3]);
+	memcpy(brand, regs, 48);
+	brand[48] = '\0';
 
-	while (fgets(line, sizeof(line), cpuinfo) != NULL) {
-		if (strncmp(line, "model name", 10) == 0) {
+	for (src = brand; *src; src++) {
+		if (*src == ' ' && (n == 0 || out[n - 1] == ' '))
+			continue;
+		out[n++] = *src;
+	}
+	while (n > 0 && out[n - 1] == ' ')
+		n--;
+	out[n] = '\0';
+	if (n == 0)
+		return NULL;
+
+	if (debug_enabled()) {
+		char vendor[13];
+
+		__get_cpuid(0, &a, &b, &c, &d);
+		memcpy(vendor, &b, 4);
+		memcpy(vendor + 4, &d, 4);
+		memcpy(vendor + 8, &c, 4);
+		vendor[12] = '\0';
+		__get_cpuid(1, &a, &b, &c, &d);
+		debug_log("cpu: name from cpuid (%s family %u model %u)", vendor,
+			  ((a >> 8) & 0xf) + ((a >> 20) & 0xff),
+			  ((a >> 4) & 0xf) | (((a >> 16) & 0xf) << 4));
+	}
+	return xstrdup(out);
+}
+
+/*
+ * Deterministic cache parameters: leaf 4 on Intel, 0x8000001d on AMD (when the
+ * topology extensions bit is set). Used when sysfs does not expose cache/index*.
+ */
+static int cpuid_cache_levels(struct cpu_cache_level *out, int max, int threads)
+{
+	unsigned int a, b, c, d, leaf = 4;
+	unsigned int i;
+	int n = 0;
+
+	if (__get_cpuid(0x80000001, &a, &b, &c, &d) && (c & (1u << 22)))
+		leaf = 0x8000001d;
+	else if (!__get_cpuid(0, &a, &b, &c, &d) || a < 4)
+		return 0;
+
+	for (i = 0; n < max && i < 16; i++) {
+		unsigned int type, sharing;
+		long size;
+
+		__cpuid_count(leaf, i, a, b, c, d);
+		type = a & 0x1f;
+		if (type == 0)
+			break;
+		size = (long)(((b >> 22) & 0x3ff) + 1) * (((b >> 12) & 0x3ff) + 1) *
+		       ((b & 0xfff) + 1) * (c + 1);
+		sharing = ((a >> 14) & 0xfff) + 1;
+		out[n].level = (int)((a >> 5) & 7);
+		out[n].type = type == 1 ? 'd' : type == 2 ? 'i' : 'u';
+		out[n].total_kb = size / 1024 * (long)(((unsigned int)threads + sharing - 1) / sharing);
+		n++;
+	}
+	if (n)
+		debug_log("cpu: cache sizes from cpuid leaf 0x%x", leaf);
+	return n;
+}
+#endif
+
+struct cpuinfo_scan {
+	int scanned;
+	char model[256];
+	double mhz_sum;
+	double mhz_max;
+	int mhz_count;
+};
+
+static struct cpuinfo_scan cpuinfo;
+
+/*
+ * Collects the model name and every "cpu MHz" field in one pass over
+ * /proc/cpuinfo, whichever of the name and frequency probes asks first.
+ */
+static const struct cpuinfo_scan *cpuinfo_get(void)
+{
+	FILE *f;
+	char line[256];
+
+	if (cpuinfo.scanned)
+		return &cpuinfo;
+	cpuinfo.scanned = 1;
+	f = fopen("/proc/cpuinfo", "r");
+	if (!f)
+		return &cpuinfo;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char *colon;
+
+		if (!cpuinfo.model[0] && strncmp(line, "model name", 10) == 0) {
 			colon = strchr(line, ':');
 			if (colon != NULL) {
-				char* name_start = colon + 2;
+				char *name_start = colon + 2;
+
 				name_start[strcspn(name_start, "\n")] = '\0';
-				cpu_name = strdup(name_start);
+				snprintf(cpuinfo.model, sizeof(cpuinfo.model), "%s", name_start);
 			}
+		} else if (strncmp(line, "cpu MHz", 7) == 0) {
+			colon = strchr(line, ':');
+			if (colon != NULL) {
+				double mhz = strtod(colon + 1, NULL);
+
+				cpuinfo.mhz_sum += mhz;
+				if (mhz > cpuinfo.mhz_max)
+					cpuinfo.mhz_max = mhz;
+				cpuinfo.mhz_count++;
+			}
+		}
+	}
+	fclose(f);
+	return &cpuinfo;
+}
+
+static char *cpuinfo_model_name(void)
+{
+	const struct cpuinfo_scan *ci = cpuinfo_get();
+
+	debug_log("cpu: name from /proc/cpuinfo");
+	if (!ci->model[0])
+		return NULL;
+	return xstrdup(ci->model);
+}
+
+char* get_cpu_name(void)
+{
+#ifdef HAVE_CPUID
+	char *name = cpuid_brand_string();
+
+	if (name)
+		return name;
+#endif
+	return cpuinfo_model_name();
+}
+
+#define BITS_PER_LONG	(sizeof(unsigned long) * CHAR_BIT)
+
+static int bit_test(const unsigned long *bits, size_t n)
+{
+	return (bits[n / BITS_PER_LONG] >> (n % BITS_PER_LONG)) & 1UL;
+}
+
+static size_t bitmap_weight(const unsigned long *bits, size_t nlongs)
+{
+	size_t i, w = 0;
+
+	for (i = 0; i < nlongs; i++)
+		w += (size_t)__builtin_popcountl(bits[i]);
+	return w;
+}
+
+/* Parses a kernel cpu list ("0-3,8-11") into a bitmap of nbits bits. */
+static size_t cpulist_parse(const char *s, unsigned long *bits, size_t nbits)
+{
+	size_t cnt = 0;
+
+	while (*s) {
+		char *end;
+		unsigned long a, b, i;
+
+		a = strtoul(s, &end, 10);
+		if (end == s)
 			break;
+		b = a;
+		s = end;
+		if (*s == '-') {
+			b = strtoul(s + 1, &end, 10);
+			s = end;
+		}
+		for (i = a; i <= b && i < nbits; i++) {
+			if (!bit_test(bits, i))
+				cnt++;
+			bits[i / BITS_PER_LONG] |= 1UL << (i % BITS_PER_LONG);
 		}
+		if (*s == ',')
+			s++;
+		else
+			break;
 	}
+	return cnt;
+}
+
+/*
+ * Large machines list a few thousand cpuN directories, so the probe never
+ * walks all of them: core and package membership is read once per core and
+ * once per package (every sibling listed in core_cpus_list is skipped), and
+ * the caches are sampled from one representative CPU per hybrid class.
+ */
+static void cpu_topology_probe(struct cpu_topology *t)
+{
+	char buf[4096];
+	char path[96];
+	unsigned long *online, *core_seen, *pkg_seen, *atom, *cls, *cache_seen;
+	size_t nbits, nlongs, cpu;
+	int dfd, idx, ncls, c;
+	long reps[2];
 
-	fclose(cpuinfo);
-	return cpu_name;
-}
\ No newline at end of file
+	memset(t, 0, sizeof(*t));
+	dfd = open("/sys/devices/system/cpu", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dfd < 0)
+		return;
+
+	nbits = 1;
+	if (read_file_at(dfd, "possible", buf, sizeof(buf)) > 0) {
+		const char *last = buf + strlen(buf);
+
+		while (last > buf && isdigit((unsigned char)last[-1]))
+			last--;
+		nbits = strtoul(last, NULL, 10) + 1;
+	}
+	nlongs = (nbits + BITS_PER_LONG - 1) / BITS_PER_LONG;
+	online = calloc(nlongs * 6, sizeof(unsigned long));
+	if (!online) {
+		close(dfd);
+		return;
+	}
+	core_seen = online + nlongs;
+	pkg_seen = core_seen + nlongs;
+	atom = pkg_seen + nlongs;
+	cls = atom + nlongs;
+	cache_seen = cls + nlongs;
+
+	if (read_file_at(dfd, "online", buf, sizeof(buf)) <= 0 ||
+	    cpulist_parse(buf, online, nbits) == 0) {
+		free(online);
+		close(dfd);
+		return;
+	}
+	t->threads = (int)bitmap_weight(online, nlongs);
+	t->hybrid = read_file_at(AT_FDCWD, "/sys/devices/cpu_atom/cpus", buf, sizeof(buf)) > 0 &&
+		    cpulist_parse(buf, atom, nbits) > 0;
+
+	for (cpu = 0; cpu < nbits; cpu++) {
+		if (!bit_test(online, cpu))
+			continue;
+		if (!bit_test(core_seen, cpu)) {
+			snprintf(path, sizeof(path), "cpu%zu/topology/core_cpus_list", cpu);
+			if (read_file_at(dfd, path, buf, sizeof(buf)) <= 0) {
+				snprintf(path, sizeof(path), "cpu%zu/topology/thread_siblings_list", cpu);
+				if (read_file_at(dfd, path, buf, sizeof(buf)) <= 0)
+					snprintf(buf, sizeof(buf), "%zu", cpu);
+			}
+			cpulist_parse(buf, core_seen, nbits);
+			t->cores++;
+			if (t->hybrid && bit_test(atom, cpu))
+				t->ecores++;
+			else
+				t->pcores++;
+		}
+		if (!bit_test(pkg_seen, cpu)) {
+			snprintf(path, sizeof(path), "cpu%zu/topology/package_cpus_list", cpu);
+			if (read_file_at(dfd, path, buf, sizeof(buf)) <= 0) {
+				snprintf(path, sizeof(path), "cpu%zu/topology/core_siblings_list", cpu);
+				if (read_file_at(dfd, path, buf, sizeof(buf)) <= 0)
+					strcpy(buf, "0-65535");
+			}
+			cpulist_parse(buf, pkg_seen, nbits);
+			t->sockets++;
+		}
+	}
+
+	/* One representative CPU per class: all CPUs, or P cores then E cores. */
+	ncls = 0;
+	for (cpu = 0; cpu < nbits && ncls < 2; cpu++) {
+		if (!bit_test(online, cpu))
+			continue;
+		if (ncls == 0 || (t->hybrid && bit_test(atom, cpu) != bit_test(atom, (size_t)reps[0])))
+			reps[ncls++] = (long)cpu;
+		if (!t->hybrid)
+			break;
+	}
+
+	for (idx = 0; idx < CPU_CACHE_LEVELS; idx++) {
+		memset(cache_seen, 0, nlongs * sizeof(unsigned long));
+		for (c = 0; c < ncls; c++) {
+			struct cpu_cache_level *cl;
+			unsigned long *shared = cls;
+			size_t i, in_cls = 0, shared_in_cls = 0;
+			char type[16];
+			long level, size_kb;
+
+			if (bit_test(cache_seen, (size_t)reps[c]))
+				continue;
+			snprintf(path, sizeof(path), "cpu%ld/cache/index%d/level", reps[c], idx);
+			level = read_long_at(dfd, path, -1);
+			if (level < 1)
+				break;
+			snprintf(path, sizeof(path), "cpu%ld/cache/index%d/type", reps[c], idx);
+			if (read_file_at(dfd, path, type, sizeof(type)) <= 0)
+				continue;
+			snprintf(path, sizeof(path), "cpu%ld/cache/index%d/size", reps[c], idx);
+			size_kb = read_long_at(dfd, path, 0);
+			snprintf(path, sizeof(path), "cpu%ld/cache/index%d/shared_cpu_list", reps[c], idx);
+			memset(shared, 0, nlongs * sizeof(unsigned long));
+			if (read_file_at(dfd, path, buf, sizeof(buf)) <= 0)
+				snprintf(buf, sizeof(buf), "%ld", reps[c]);
+			cpulist_parse(buf, shared, nbits);
+
+			for (i = 0; i < nbits; i++) {
+				int same;
+
+				if (!bit_test(online, i))
+					continue;
+				same = !t->hybrid || bit_test(atom, i) == bit_test(atom, (size_t)reps[c]);
+				if (same) {
+					in_cls++;
+					if (bit_test(shared, i))
+						shared_in_cls++;
+					cache_seen[i / BITS_PER_LONG] |= 1UL << (i % BITS_PER_LONG);
+				}
+				if (bit_test(shared, i))
+					cache_seen[i / BITS_PER_LONG] |= 1UL << (i % BITS_PER_LONG);
+			}
+			if (shared_in_cls == 0)
+				shared_in_cls = 1;
+
+			cl = &t->cache[idx];
+			cl->level = (int)level;
+			cl->type = type[0] == 'D' ? 'd' : type[0] == 'I' ? 'i' : 'u';
+			cl->total_kb += size_kb * (long)((in_cls + shared_in_cls - 1) / shared_in_cls);
+		}
+	}
+
+#ifdef HAVE_CPUID
+	for (idx = 0; idx < CPU_CACHE_LEVELS && t->cache[idx].level == 0; idx++)
+		;
+	if (idx == CPU_CACHE_LEVELS)
+		cpuid_cache_levels(t->cache, CPU_CACHE_LEVELS, t->threads);
+#endif
+	if (t->sockets == 0)
+		t->sockets = 1;
+	if (t->cores == 0)
+		t->cores = t->threads;
+	close(dfd);
+	free(online);
+
+	if (read_file_at(AT_FDCWD, "/sys/devices/system/node/online", buf, sizeof(buf)) > 0) {
+		unsigned long nodes[1024 / BITS_PER_LONG] = { 0 };
+
+		t->numa_nodes = (int)cpulist_parse(buf, nodes, 1024);
+	}
+	t->valid = 1;
+}
+
+const struct cpu_topology *get_cpu_topology(void)
+{
+	static struct cpu_topology topo;
+	static int probed;
+
+	if (!probed) {
+		cpu_topology_probe(&topo);
+		probed = 1;
+	}
+	return topo.valid ? &topo : NULL;
+}
+
+static void format_kb(char *buf, size_t sz, long kb)
+{
+	if (kb >= 1024 * 1024)
+		snprintf(buf, sz, "%.1fG", kb / (1024.0 * 1024.0));
+	else if (kb >= 1024 && kb % 1024 == 0)
+		snprintf(buf, sz, "%ldM", kb / 1024);
+	else if (kb >= 1024)
+		snprintf(buf, sz, "%.1fM", kb / 1024.0);
+	else
+		snprintf(buf, sz, "%ldK", kb);
+}
+
+char *get_cpu_cache(void)
+{
+	const struct cpu_topology *t = get_cpu_topology();
+	char out[256];
+	size_t len = 0;
+	int i;
+
+	if (!t)
+		return xstrdup("unknown");
+	out[0] = '\0';
+	for (i = 0; i < CPU_CACHE_LEVELS; i++) {
+		const struct cpu_cache_level *cl = &t->cache[i];
+		char size[32];
+
+		if (cl->level == 0 || cl->total_kb == 0)
+			continue;
+		format_kb(size, sizeof(size), cl->total_kb);
+		len += (size_t)snprintf(out + len, sizeof(out) - len, "%sL%d%s %s",
+					len ? ", " : "", cl->level,
+					cl->type == 'd' ? "d" : cl->type == 'i' ? "i" : "", size);
+		if (len >= sizeof(out))
+			break;
+	}
+	return xstrdup(len ? out : "unknown");
+}
+
+char *get_cpu_topology_str(void)
+{
+	const struct cpu_topology *t = get_cpu_topology();
+	char *name = get_cpu_name();
+	char sockets[16] = "";
+	char cores[48];
+	char *res;
+	size_t n;
+
+	if (!name)
+		name = xstrdup("unknown");
+	if (!t || !name)
+		return name;
+	if (t->sockets > 1)
+		snprintf(sockets, sizeof(sockets), "%dx ", t->sockets);
+	if (t->hybrid && t->ecores > 0)
+		snprintf(cores, sizeof(cores), "%dP+%dE/%dT", t->pcores, t->ecores, t->threads);
+	else
+		snprintf(cores, sizeof(cores), "%dC/%dT", t->cores, t->threads);
+
+	n = strlen(sockets) + strlen(name) + strlen(cores) + 4;
+	res = malloc(n);
+	if (!res)
+		return name;
+	snprintf(res, n, "%s%s (%s)", sockets, name, cores);
+	free(name);
+	return res;
+}
+
+
+/*
+ * CPUs sharing a frequency domain share one cpufreq policy directory, so the
+ * probe reads one set of files per policy instead of one per CPU and weighs
+ * each policy by the number of CPUs it covers.
+ */
+static void cpufreq_probe(struct cpu_freq *cf)
+{
+	char buf[4096];
+	char path[300];
+	DIR *d;
+	struct dirent *de;
+	int dfd;
+	double khz_sum = 0;
+
+	memset(cf, 0, sizeof(*cf));
+	d = opendir("/sys/devices/system/cpu/cpufreq");
+	if (d) {
+		dfd = dirfd(d);
+		while ((de = readdir(d)) != NULL) {
+			long cur, lo, hi;
+			size_t ncpu = 0;
+			const char *p;
+
+			if (strncmp(de->d_name, "policy", 6) != 0)
+				continue;
+			snprintf(path, sizeof(path), "%s/scaling_cur_freq", de->d_name);
+			cur = read_long_at(dfd, path, -1);
+			if (cur <= 0)
+				continue;
+			snprintf(path, sizeof(path), "%s/cpuinfo_min_freq", de->d_name);
+			lo = read_long_at(dfd, path, 0);
+			snprintf(path, sizeof(path), "%s/cpuinfo_max_freq", de->d_name);
+			hi = read_long_at(dfd, path, 0);
+			snprintf(path, sizeof(path), "%s/affected_cpus", de->d_name);
+			if (read_file_at(dfd, path, buf, sizeof(buf)) > 0) {
+				for (p = buf; *p; p++)
+					if (isdigit((unsigned char)*p) && (p == buf || p[-1] == ' '))
+						ncpu++;
+			}
+			if (ncpu == 0)
+				ncpu = 1;
+
+			khz_sum += (double)cur * (double)ncpu;
+			cf->count += (int)ncpu;
+			if (cur > cf->cur_max_khz)
+				cf->cur_max_khz = cur;
+			if (lo > 0 && (cf->min_khz == 0 || lo < cf->min_khz))
+				cf->min_khz = lo;
+			if (hi > cf->max_khz)
+				cf->max_khz = hi;
+
+			snprintf(path, sizeof(path), "%s/scaling_governor", de->d_name);
+			if (read_file_at(dfd, path, buf, 64) > 0 && !strstr(cf->governor, buf)) {
+				size_t len = strlen(cf->governor);
+
+				snprintf(cf->governor + len, sizeof(cf->governor) - len, "%s%s",
+					 len ? ", " : "", buf);
+			}
+		}
+		closedir(d);
+	}
+	if (cf->count > 0) {
+		cf->cur_avg_khz = (long)(khz_sum / cf->count);
+		debug_log("cpu: frequency from cpufreq (%d cpus)", cf->count);
+		return;
+	}
+
+	{
+		const struct cpuinfo_scan *ci = cpuinfo_get();
+
+		if (ci->mhz_count > 0) {
+			cf->count = ci->mhz_count;
+			cf->cur_avg_khz = (long)(ci->mhz_sum / ci->mhz_count * 1000.0);
+			cf->cur_max_khz = (long)(ci->mhz_max * 1000.0);
+			debug_log("cpu: frequency from /proc/cpuinfo (%d cpus)", cf->count);
+		}
+	}
+}
+
+const struct cpu_freq *get_cpu_freq(void)
+{
+	static struct cpu_freq cf;
+	static int probed;
+
+	if (!probed) {
+		cpufreq_probe(&cf);
+		probed = 1;
+	}
+	return cf.count > 0 ? &cf : NULL;
+}
+
+char *get_cpu_freq_str(void)
+{
+	const struct cpu_freq *cf = get_cpu_freq();
+	char buf[128];
+	int n;
+
+	if (!cf)
+		return xstrdup("unknown");
+	n = snprintf(buf, sizeof(buf), "%.2f GHz avg, %.2f GHz max",
+		     cf->cur_avg_khz / 1e6, cf->cur_max_khz / 1e6);
+	if (cf->max_khz > 0)
+		snprintf(buf + n, sizeof(buf) - (size_t)n, " (%.2f-%.2f GHz)",
+			 cf->min_khz / 1e6, cf->max_khz / 1e6);
+	return xstrdup(buf);
+}
+
+char *get_governor_str(void)
+{
+	const struct cpu_freq *cf = get_cpu_freq();
+
+	if (!cf || !cf->governor[0])
+		return xstrdup("unknown");
+	return xstrdup(cf->governor);
+}
+
+
+struct thermal_paths {
+	char cpu[128];
+	char gpu[128];
+};
+
+struct hwmon_sensor {
+	const char *chip;
+	const char *label;	/* NULL: first temp*_input of the chip */
+	int gpu;
+	int rank;		/* lower wins */
+};
+
+static const struct hwmon_sensor hwmon_sensors[] = {
+	{ "coretemp",	 "Package id 0", 0, 0 },
+	{ "k10temp",	 "Tdie",	 0, 0 },
+	{ "k10temp",	 "Tctl",	 0, 1 },
+	{ "zenpower",	 "Tdie",	 0, 0 },
+	{ "cpu_thermal", NULL,		 0, 2 },
+	{ "soc_thermal", NULL,		 0, 3 },
+	{ "coretemp",	 NULL,		 0, 4 },
+	{ "k10temp",	 NULL,		 0, 4 },
+	{ "acpitz",	 NULL,		 0, 9 },
+	{ "amdgpu",	 "edge",	 1, 0 },
+	{ "amdgpu",	 NULL,		 1, 1 },
+	{ "radeon",	 NULL,		 1, 1 },
+	{ "nouveau",	 NULL,		 1, 1 },
+	{ NULL,		 NULL,		 0, 0 }
+};
+
+static int boot_id(char *buf, size_t sz)
+{
+	return read_file_at(AT_FDCWD, "/proc/sys/kernel/random/boot_id", buf, sz) > 0 ? 0 : -1;
+}
+
+/*
+ * Walks /sys/class/hwmon once, matching each chip name and temp*_label against
+ * hwmon_sensors, and keeps the best-ranked input for the CPU and the GPU.
+ */
+static void thermal_discover(struct thermal_paths *tp)
+{
+	DIR *d;
+	struct dirent *de;
+	int cpu_rank = 100, gpu_rank = 100;
+
+	memset(tp, 0, sizeof(*tp));
+	d = opendir("/sys/class/hwmon");
+	if (!d)
+		return;
+	while ((de = readdir(d)) != NULL) {
+		char path[300];
+		char chip[64];
+		DIR *hd;
+		struct dirent *he;
+		int hfd;
+
+		if (strncmp(de->d_name, "hwmon", 5) != 0)
+			continue;
+		snprintf(path, sizeof(path), "/sys/class/hwmon/%s", de->d_name);
+		hd = opendir(path);
+		if (!hd)
+			continue;
+		hfd = dirfd(hd);
+		if (read_file_at(hfd, "name", chip, sizeof(chip)) <= 0) {
+			closedir(hd);
+			continue;
+		}
+		while ((he = readdir(hd)) != NULL) {
+			char label[64] = "";
+			char file[300];
+			int i, n;
+			size_t len = strlen(he->d_name);
+
+			if (strncmp(he->d_name, "temp", 4) != 0 || len < 10 ||
+			    strcmp(he->d_name + len - 6, "_input") != 0)
+				continue;
+			n = atoi(he->d_name + 4);
+			snprintf(file, sizeof(file), "temp%d_label", n);
+			read_file_at(hfd, file, label, sizeof(label));
+
+			for (i = 0; hwmon_sensors[i].chip; i++) {
+				const struct hwmon_sensor *hs = &hwmon_sensors[i];
+				int *best = hs->gpu ? &gpu_rank : &cpu_rank;
+				char *dst = hs->gpu ? tp->gpu : tp->cpu;
+				size_t dsz = hs->gpu ? sizeof(tp->gpu) : sizeof(tp->cpu);
+
+				if (strcmp(hs->chip, chip) != 0)
+					continue;
+				if (hs->label && strcmp(hs->label, label) != 0)
+					continue;
+				/* Unlabelled matches keep the chip's lowest-numbered input. */
+				if (hs->rank < *best || (hs->rank == *best && !hs->label &&
+							 atoi(strrchr(dst, '/') + 5) > n)) {
+					*best = hs->rank;
+					snprintf(dst, dsz, "%.80s/%.40s", path, he->d_name);
+				}
+				break;
+			}
+		}
+		closedir(hd);
+	}
+	closedir(d);
+	debug_log("thermal: discovered cpu=%s gpu=%s", tp->cpu[0] ? tp->cpu : "-",
+		  tp->gpu[0] ? tp->gpu : "-");
+}
+
+/*
+ * Sensor paths are cached per boot (hwmon numbering can change across boots),
+ * so later runs read only the one or two tempN_input files.
+ */
+static const struct thermal_paths *thermal_paths_get(void)
+{
+	static struct thermal_paths tp;
+	static int resolved;
+	char id[64];
+	char cached[400];
+
+	if (resolved)
+		return &tp;
+	resolved = 1;
+	if (boot_id(id, sizeof(id)) == 0 && cache_read("thermal", cached, sizeof(cached)) == 0) {
+		char *save = NULL;
+		char *line = strtok_r(cached, "\n", &save);
+
+		if (line && !strcmp(line, id)) {
+			char *cpu = strtok_r(NULL, "\n", &save);
+			char *gpu = strtok_r(NULL, "\n", &save);
+
+			snprintf(tp.cpu, sizeof(tp.cpu), "%s", cpu && *cpu != '-' ? cpu : "");
+			snprintf(tp.gpu, sizeof(tp.gpu), "%s", gpu && *gpu != '-' ? gpu : "");
+			debug_log("thermal: sensor paths from cache");
+			return &tp;
+		}
+	}
+
+	thermal_discover(&tp);
+	if (boot_id(id, sizeof(id)) == 0) {
+		snprintf(cached, sizeof(cached), "%s\n%s\n%s\n", id,
+			 tp.cpu[0] ? tp.cpu : "-", tp.gpu[0] ? tp.gpu : "-");
+		cache_write("thermal", cached);
+	}
+	return &tp;
+}
+
+static char *temp_str(const char *path)
+{
+	char buf[32];
+	long milli;
+
+	if (!path[0])
+		return xstrdup("unknown");
+	milli = read_long_at(AT_FDCWD, path, LONG_MIN);
+	if (milli == LONG_MIN)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%.1f°C", milli / 1000.0);
+	return xstrdup(buf);
+}
+
+char *get_cpu_temp(void)
+{
+	return temp_str(thermal_paths_get()->cpu);
+}
+
+char *get_gpu_temp(void)
+{
+	return temp_str(thermal_paths_get()->gpu);
+}
+
+
+struct power_info {
+	int batteries;
+	int ac_online;		/* -1 when no Mains/USB supply reports it */
+	double capacity;	/* percent */
+	char status[32];	/* of the first battery */
+	double energy_now;	/* µWh, with charge_* converted through voltage_now */
+	double energy_full;
+	double power_now;	/* µW */
+	double charge_now;	/* µAh of batteries that report no voltage */
+	double charge_full;
+	double current_now;	/* µA */
+	double watts;
+};
+
+/*
+ * One read of each supply's uevent gives every POWER_SUPPLY_* attribute at
+ * once. Peripheral batteries (SCOPE=Device, e.g. wireless mice) are ignored.
+ */
+static void power_probe(struct power_info *pi)
+{
+	DIR *d;
+	struct dirent *de;
+	double cap_sum = 0;
+	int dfd;
+
+	memset(pi, 0, sizeof(*pi));
+	pi->ac_online = -1;
+	d = opendir("/sys/class/power_supply");
+	if (!d)
+		return;
+	dfd = dirfd(d);
+	while ((de = readdir(d)) != NULL) {
+		char buf[4096];
+		char path[300];
+		char *line, *save = NULL;
+		char type[16] = "", status[32] = "", scope[16] = "";
+		double cap = -1, e_now = -1, e_full = -1, p_now = -1;
+		double c_now = -1, c_full = -1, i_now = -1, volt = -1;
+		int online = -1;
+
+		if (de->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/uevent", de->d_name);
+		if (read_file_at(dfd, path, buf, sizeof(buf)) <= 0)
+			continue;
+		for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+			char *eq = strchr(line, '=');
+			const char *k;
+
+			if (!eq || strncmp(line, "POWER_SUPPLY_", 13) != 0)
+				continue;
+			*eq = '\0';
+			k = line + 13;
+			if (!strcmp(k, "TYPE"))
+				snprintf(type, sizeof(type), "%s", eq + 1);
+			else if (!strcmp(k, "STATUS"))
+				snprintf(status, sizeof(status), "%s", eq + 1);
+			else if (!strcmp(k, "SCOPE"))
+				snprintf(scope, sizeof(scope), "%s", eq + 1);
+			else if (!strcmp(k, "ONLINE"))
+				online = atoi(eq + 1);
+			else if (!strcmp(k, "CAPACITY"))
+				cap = atof(eq + 1);
+			else if (!strcmp(k, "ENERGY_NOW"))
+				e_now = atof(eq + 1);
+			else if (!strcmp(k, "ENERGY_FULL"))
+				e_full = atof(eq + 1);
+			else if (!strcmp(k, "POWER_NOW"))
+				p_now = atof(eq + 1);
+			else if (!strcmp(k, "CHARGE_NOW"))
+				c_now = atof(eq + 1);
+			else if (!strcmp(k, "CHARGE_FULL"))
+				c_full = atof(eq + 1);
+			else if (!strcmp(k, "CURRENT_NOW"))
+				i_now = atof(eq + 1);
+			else if (!strcmp(k, "VOLTAGE_NOW"))
+				volt = atof(eq + 1);
+		}
+
+		if (!strcmp(type, "Mains") || !strcmp(type, "USB")) {
+			if (online >= 0)
+				pi->ac_online = pi->ac_online > 0 ? 1 : online;
+			continue;
+		}
+		if (strcmp(type, "Battery") != 0 || !strcmp(scope, "Device"))
+			continue;
+
+		if (pi->batteries == 0)
+			snprintf(pi->status, sizeof(pi->status), "%s", status);
+		pi->batteries++;
+		/* µAh * V = µWh, and µA * V = µW. */
+		if (e_now < 0 && c_now >= 0 && volt > 0) {
+			e_now = c_now * volt / 1e6;
+			e_full = c_full * volt / 1e6;
+			p_now = i_now > 0 ? i_now * volt / 1e6 : -1;
+		}
+		if (e_now >= 0 && e_full > 0) {
+			pi->energy_now += e_now;
+			pi->energy_full += e_full;
+			if (p_now > 0) {
+				pi->power_now += p_now;
+				pi->watts += p_now / 1e6;
+			}
+		} else if (c_now >= 0 && c_full > 0) {
+			pi->charge_now += c_now;
+			pi->charge_full += c_full;
+			if (i_now > 0)
+				pi->current_now += i_now;
+		}
+		if (cap < 0 && e_full > 0)
+			cap = 100.0 * e_now / e_full;
+		else if (cap < 0 && c_full > 0)
+			cap = 100.0 * c_now / c_full;
+		cap_sum += cap > 0 ? cap : 0;
+	}
+	closedir(d);
+
+	/* Energy and charge cannot be added up, so a mix falls back to the mean. */
+	if (pi->energy_full > 0 && pi->charge_full <= 0)
+		pi->capacity = 100.0 * pi->energy_now / pi->energy_full;
+	else if (pi->charge_full > 0 && pi->energy_full <= 0)
+		pi->capacity = 100.0 * pi->charge_now / pi->charge_full;
+	else if (pi->batteries)
+		pi->capacity = cap_sum / pi->batteries;
+}
+
+static const struct power_info *power_info_get(void)
+{
+	static struct power_info pi;
+	static int probed;
+
+	if (!probed) {
+		power_probe(&pi);
+		probed = 1;
+	}
+	return &pi;
+}
+
+char *get_battery_str(void)
+{
+	const struct power_info *pi = power_info_get();
+	double now = 0, full = 0, rate = 0;
+	char buf[96];
+	int n;
+
+	if (pi->batteries == 0)
+		return xstrdup("none");
+	if (pi->charge_full <= 0) {
+		now = pi->energy_now;
+		full = pi->energy_full;
+		rate = pi->power_now;
+	} else if (pi->energy_full <= 0) {
+		now = pi->charge_now;
+		full = pi->charge_full;
+		rate = pi->current_now;
+	}
+	n = snprintf(buf, sizeof(buf), "%.0f%%", pi->capacity);
+	if (pi->status[0])
+		n += snprintf(buf + n, sizeof(buf) - (size_t)n, " (%s", pi->status);
+	if (rate > 0 && full > 0) {
+		double hours = -1;
+		const char *what = NULL;
+
+		if (!strcmp(pi->status, "Discharging")) {
+			hours = now / rate;
+			what = "left";
+		} else if (!strcmp(pi->status, "Charging")) {
+			hours = (full - now) / rate;
+			what = "to full";
+		}
+		if (what && hours >= 0 && hours < 100) {
+			long mins = (long)(hours * 60.0);
+
+			n += snprintf(buf + n, sizeof(buf) - (size_t)n, ", %ldh %ldm %s",
+				      mins / 60, mins % 60, what);
+		}
+	}
+	if (pi->status[0])
+		snprintf(buf + n, sizeof(buf) - (size_t)n, ")");
+	return xstrdup(buf);
+}
+
+char *get_power_str(void)
+{
+	const struct power_info *pi = power_info_get();
+	char buf[64];
+	const char *src;
+
+	if (pi->ac_online > 0 || (pi->batteries && strcmp(pi->status, "Discharging") != 0))
+		src = "AC";
+	else if (pi->batteries)
+		src = "Battery";
+	else if (pi->ac_online == 0)
+		src = "Offline";
+	else
+		return xstrdup("");
+	if (pi->watts > 0)
+		snprintf(buf, sizeof(buf), "%s, %.1f W", src, pi->watts);
+	else
+		snprintf(buf, sizeof(buf), "%s", src);
+	return xstrdup(buf);
+}
+
+
+
+#define DISK_STATVFS_TIMEOUT_MS		300
+#define DISK_MAX_MOUNTS			32
+
+/* Virtual, in-memory and image filesystems that never hold user data. */
+static const char *const pseudo_fs[] = {
+	"proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "ramfs", "cgroup", "cgroup2",
+	"securityfs", "pstore", "bpf", "debugfs", "tracefs", "configfs", "fusectl",
+	"hugetlbfs", "mqueue", "autofs", "binfmt_misc", "efivarfs", "nsfs",
+	"rpc_pipefs", "selinuxfs", "overlay", "aufs", "squashfs", "iso9660",
+	"fuse.gvfsd-fuse", "fuse.portal", "fuse.lxcfs", "nfsd", NULL
+};
+
+static const char *const pseudo_prefixes[] = {
+	"/proc", "/sys", "/dev", "/run", "/snap", "/var/lib/docker", NULL
+};
+
+/* Removable media is mounted under /run/media/$USER by udisks. */
+static int mount_is_pseudo(const char *path)
+{
+	size_t i, n;
+
+	if (!strncmp(path, "/run/media/", 11))
+		return 0;
+	for (i = 0; pseudo_prefixes[i]; i++) {
+		n = strlen(pseudo_prefixes[i]);
+		if (!strncmp(path, pseudo_prefixes[i], n) && (path[n] == '\0' || path[n] == '/'))
+			return 1;
+	}
+	return 0;
+}
+
+struct disk_usage {
+	char path[256];
+	unsigned long long total;
+	unsigned long long used;
+	int state;		/* 0: timed out, 1: ok, -1: statvfs failed */
+};
+
+struct statvfs_batch;
+
+struct statvfs_job {
+	struct statvfs_batch *batch;
+	struct disk_usage du;
+};
+
+/*
+ * Shared between the caller and its workers. A worker stuck on a dead network
+ * mount may outlive the caller, so the last one to drop its reference frees it.
+ */
+struct statvfs_batch {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	size_t pending;
+	int refs;
+	struct statvfs_job jobs[];
+};
+
+static void statvfs_batch_put(struct statvfs_batch *b)
+{
+	int last = --b->refs == 0;
+
+	pthread_mutex_unlock(&b->lock);
+	if (last) {
+		pthread_cond_destroy(&b->cond);
+		pthread_mutex_destroy(&b->lock);
+		free(b);
+	}
+}
+
+static void *statvfs_worker(void *arg)
+{
+	struct statvfs_job *job = arg;
+	struct statvfs_batch *b = job->batch;
+	struct statvfs fs;
+	int ok = statvfs(job->du.path, &fs) == 0;
+
+	pthread_mutex_lock(&b->lock);
+	if (ok) {
+		job->du.total = (unsigned long long)fs.f_blocks * fs.f_frsize;
+		job->du.used = (unsigned long long)(fs.f_blocks - fs.f_bfree) * fs.f_frsize;
+		job->du.state = 1;
+	} else {
+		job->du.state = -1;
+	}
+	b->pending--;
+	pthread_cond_signal(&b->cond);
+	statvfs_batch_put(b);
+	return NULL;
+}
+
+/*
+ * Runs statvfs() on every entry of du[] in parallel detached threads and waits
+ * at most DISK_STATVFS_TIMEOUT_MS. Entries that did not answer keep state 0.
+ */
+static void statvfs_parallel(struct disk_usage *du, size_t n)
+{
+	struct statvfs_batch *b;
+	pthread_attr_t attr;
+	struct timespec deadline;
+	size_t i;
+
+	b = calloc(1, sizeof(*b) + n * sizeof(b->jobs[0]));
+	if (!b)
+		return;
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_cond_init(&b->cond, NULL);
+	b->refs = 1;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_attr_setstacksize(&attr, 64 * 1024);
+
+	pthread_mutex_lock(&b->lock);
+	for (i = 0; i < n; i++) {
+		pthread_t th;
+
+		b->jobs[i].batch = b;
+		b->jobs[i].du = du[i];
+		b->jobs[i].du.state = 0;
+		if (pthread_create(&th, &attr, statvfs_worker, &b->jobs[i]) == 0) {
+			b->refs++;
+			b->pending++;
+		} else {
+			b->jobs[i].du.state = -1;
+		}
+	}
+	pthread_attr_destroy(&attr);
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += DISK_STATVFS_TIMEOUT_MS * 1000000L;
+	deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+	deadline.tv_nsec %= 1000000000L;
+	while (b->pending > 0)
+		if (pthread_cond_timedwait(&b->cond, &b->lock, &deadline) != 0)
+			break;
+	for (i = 0; i < n; i++) {
+		du[i] = b->jobs[i].du;
+		if (du[i].state == 0)
+			debug_log("disk: statvfs(%s) timed out", du[i].path);
+	}
+	statvfs_batch_put(b);
+}
+
+/* Undoes the octal escapes (\040 for a space) used by mountinfo. */
+static void mountinfo_unescape(char *s)
+{
+	char *w = s;
+
+	while (*s) {
+		if (s[0] == '\\' && s[1] >= '0' && s[1] <= '3' && s[2] >= '0' && s[2] <= '7' &&
+		    s[3] >= '0' && s[3] <= '7') {
+			*w++ = (char)(((s[1] - '0') << 6) | ((s[2] - '0') << 3) | (s[3] - '0'));
+			s += 4;
+		} else {
+			*w++ = *s++;
+		}
+	}
+	*w = '\0';
+}
+
+static struct disk_usage mounts[DISK_MAX_MOUNTS];
+static size_t mount_count;
+
+/*
+ * Parses /proc/self/mountinfo once, keeps the first mount of every device
+ * that is not a pseudo, overlay or image filesystem, then stats them all in
+ * parallel.
+ */
+static void mounts_probe(void)
+{
+	static int probed;
+	char devs[DISK_MAX_MOUNTS][16];
+	char *buf, *line, *save = NULL;
+	size_t i;
+
+	if (probed)
+		return;
+	probed = 1;
+	buf = read_file_alloc("/proc/self/mountinfo", NULL);
+	if (!buf)
+		return;
+	for (line = strtok_r(buf, "\n", &save); line && mount_count < DISK_MAX_MOUNTS;
+	     line = strtok_r(NULL, "\n", &save)) {
+		char *f[6];
+		char *sep, *fstype, *fsave = NULL;
+		int nf, dup = 0;
+
+		sep = strstr(line, " - ");
+		if (!sep)
+			continue;
+		*sep = '\0';
+		fstype = strtok_r(sep + 3, " ", &fsave);
+		if (!fstype)
+			continue;
+		for (nf = 0; nf < 6; nf++) {
+			f[nf] = strtok_r(nf == 0 ? line : NULL, " ", &fsave);
+			if (!f[nf])
+				break;
+		}
+		if (nf < 5)
+			continue;
+		for (i = 0; pseudo_fs[i]; i++)
+			if (!strcmp(fstype, pseudo_fs[i]))
+				break;
+		if (pseudo_fs[i])
+			continue;
+		mountinfo_unescape(f[4]);
+		if (mount_is_pseudo(f[4]))
+			continue;
+		for (i = 0; i < mount_count; i++)
+			if (!strcmp(devs[i], f[2]))
+				dup = 1;
+		if (dup)
+			continue;
+		snprintf(devs[mount_count], sizeof(devs[0]), "%s", f[2]);
+		snprintf(mounts[mount_count].path, sizeof(mounts[0].path), "%s", f[4]);
+		mount_count++;
+	}
+	free(buf);
+	statvfs_parallel(mounts, mount_count);
+	debug_log("disk: %zu mounts from mountinfo", mount_count);
+}
+
+static void format_size_short(char *buf, size_t sz, unsigned long long bytes)
+{
+	double gb = (double)bytes / (1024.0 * 1024 * 1024);
+
+	if (gb >= 1024.0)
+		snprintf(buf, sz, "%.1fT", gb / 1024.0);
+	else
+		snprintf(buf, sz, "%.1fG", gb);
+}
+
+char *get_disks_str(void)
+{
+	char out[1024];
+	size_t i, len = 0;
+
+	mounts_probe();
+	out[0] = '\0';
+	for (i = 0; i < mount_count && len < sizeof(out); i++) {
+		const struct disk_usage *du = &mounts[i];
+		char used[16], total[16];
+
+		if (du->state == 0) {
+			len += (size_t)snprintf(out + len, sizeof(out) - len, "%s%s (timeout)",
+						len ? ", " : "", du->path);
+			continue;
+		}
+		if (du->state < 0 || du->total == 0)
+			continue;
+		format_size_short(used, sizeof(used), du->used);
+		format_size_short(total, sizeof(total), du->total);
+		len += (size_t)snprintf(out + len, sizeof(out) - len, "%s%s %s/%s",
+					len ? ", " : "", du->path, used, total);
+	}
+	return xstrdup(len ? out : "unknown");
+}
+
+char *get_disk_usage_str(const char *path)
+{
+	struct disk_usage du;
+	char res[64];
+	size_t i;
+
+	memset(&du, 0, sizeof(du));
+	for (i = 0; i < mount_count; i++)
+		if (!strcmp(mounts[i].path, path))
+			du = mounts[i];
+	if (!du.path[0]) {
+		snprintf(du.path, sizeof(du.path), "%s", path);
+		statvfs_parallel(&du, 1);
+	}
+	if (du.state == 0)
+		return xstrdup("timeout");
+	if (du.state < 0)
+		return xstrdup("unknown");
+	snprintf(res, sizeof(res), "%.1fG / %.1fG", (double)du.used / (1024.0 * 1024 * 1024),
+		 (double)du.total / (1024.0 * 1024 * 1024));
+	return xstrdup(res);
+}
+
+
+struct pci_name {
+	unsigned int vendor;
+	unsigned int device;
+	char name[128];
+};
+
+/*
+ * Looks a PCI vendor/device pair up in the hwdata pci.ids database, keeping
+ * every answer for the rest of the run so repeated controllers cost one scan.
+ */
+int pci_ids_lookup(unsigned int vendor, unsigned int device, char *buf, size_t sz)
+{
+	static const char *const paths[] = {
+		"/usr/share/hwdata/pci.ids", "/usr/share/misc/pci.ids", "/usr/share/pci.ids", NULL
+	};
+	static struct pci_name seen[16];
+	static size_t seen_count;
+	char vname[96] = "";
+	char line[256];
+	FILE *f = NULL;
+	size_t i;
+	int in_vendor = 0;
+
+	for (i = 0; i < seen_count; i++) {
+		if (seen[i].vendor == vendor && seen[i].device == device) {
+			snprintf(buf, sz, "%s", seen[i].name);
+			return seen[i].name[0] ? 0 : -1;
+		}
+	}
+	for (i = 0; paths[i] && !f; i++)
+		f = fopen(paths[i], "r");
+	buf[0] = '\0';
+	while (f && fgets(line, sizeof(line), f)) {
+		char *end;
+		unsigned long id;
+
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		line[strcspn(line, "\n")] = '\0';
+		if (line[0] != '\t') {
+			if (in_vendor)
+				break;
+			id = strtoul(line, &end, 16);
+			if (end != line && id == vendor) {
+				in_vendor = 1;
+				snprintf(vname, sizeof(vname), "%s", ltrim(end));
+			}
+		} else if (in_vendor && line[1] != '\t') {
+			id = strtoul(line + 1, &end, 16);
+			if (id == device) {
+				snprintf(buf, sz, "%s %s", vname, ltrim(end));
+				break;
+			}
+		}
+	}
+	if (f)
+		fclose(f);
+	if (!buf[0] && vname[0])
+		snprintf(buf, sz, "%s", vname);
+	if (seen_count < sizeof(seen) / sizeof(seen[0])) {
+		seen[seen_count].vendor = vendor;
+		seen[seen_count].device = device;
+		snprintf(seen[seen_count].name, sizeof(seen[0].name), "%s", buf);
+		seen_count++;
+	}
+	return buf[0] ? 0 : -1;
+}
+
+/* Names the PCI function a block device hangs off (NVMe, virtio, AHCI...). */
+static int block_controller_name(const char *dev, char *buf, size_t sz)
+{
+	char link[300];
+	char real[PATH_MAX];
+	char *slash;
+
+	snprintf(link, sizeof(link), "/sys/block/%s/device", dev);
+	if (!realpath(link, real))
+		return -1;
+	while ((slash = strrchr(real, '/')) != NULL && slash != real) {
+		unsigned int dom, bus, slot, fn;
+		char extra;
+
+		if (sscanf(slash + 1, "%x:%x:%x.%x%c", &dom, &bus, &slot, &fn, &extra) == 4) {
+			int dfd = open(real, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			long vendor, device;
+
+			if (dfd < 0)
+				return -1;
+			vendor = read_long_hex_at(dfd, "vendor");
+			device = read_long_hex_at(dfd, "device");
+			close(dfd);
+			if (vendor < 0 || device < 0)
+				return -1;
+			return pci_ids_lookup((unsigned int)vendor, (unsigned int)device, buf, sz);
+		}
+		*slash = '\0';
+	}
+	return -1;
+}
+
+/*
+ * One pass over /sys/block: model, size, rotational flag and NVMe firmware are
+ * read through the directory fd, loop/ram/zram and stacked devices are skipped.
+ */
+char *get_storage_str(void)
+{
+	static const char *const skip[] = { "loop", "ram", "zram", "dm-", "md", "sr", "fd", "nbd", NULL };
+	char out[1024];
+	size_t len = 0;
+	DIR *d;
+	struct dirent *de;
+	int dfd;
+
+	d = opendir("/sys/block");
+	if (!d)
+		return xstrdup("unknown");
+	dfd = dirfd(d);
+	out[0] = '\0';
+	while ((de = readdir(d)) != NULL && len < sizeof(out)) {
+		char path[300];
+		char model[128] = "";
+		char fw[32] = "";
+		char size[16];
+		const char *kind;
+		long sectors;
+		int i, nvme;
+
+		if (de->d_name[0] == '.')
+			continue;
+		for (i = 0; skip[i]; i++)
+			if (!strncmp(de->d_name, skip[i], strlen(skip[i])))
+				break;
+		if (skip[i])
+			continue;
+		snprintf(path, sizeof(path), "%s/size", de->d_name);
+		sectors = read_long_at(dfd, path, 0);
+		if (sectors <= 0)
+			continue;
+		nvme = !strncmp(de->d_name, "nvme", 4);
+
+		snprintf(path, sizeof(path), "%s/device/model", de->d_name);
+		read_file_at(dfd, path, model, sizeof(model));
+		rtrim_inplace(model);
+		if (!model[0] && block_controller_name(de->d_name, model, sizeof(model)) != 0)
+			snprintf(model, sizeof(model), "%.127s", de->d_name);
+		if (nvme) {
+			snprintf(path, sizeof(path), "%s/device/firmware_rev", de->d_name);
+			read_file_at(dfd, path, fw, sizeof(fw));
+			rtrim_inplace(fw);
+			kind = "NVMe";
+		} else if (!strncmp(de->d_name, "vd", 2)) {
+			kind = "virtio";
+		} else {
+			snprintf(path, sizeof(path), "%s/queue/rotational", de->d_name);
+			kind = read_long_at(dfd, path, 0) ? "HDD" : "SSD";
+		}
+		format_size_short(size, sizeof(size), (unsigned long long)sectors * 512ULL);
+		len += (size_t)snprintf(out + len, sizeof(out) - len, "%s%s %s (%s%s%s)",
+					len ? ", " : "", ltrim(model), size, kind,
+					fw[0] ? ", fw " : "", fw);
+	}
+	closedir(d);
+	return xstrdup(len ? out : "none");
+}
@@ -1,6 +1,8 @@
 #ifndef FETCH_H
 #define FETCH_H
 
+#include <stddef.h>
+
 /*
  * =====================================================================================
  *
@@ -19,12 +21,70 @@
 char *get_gpu_name(void);
 
 /**
- * @brief Fetches the current memory usage (used/total).
+ * @brief Fetches the current memory usage (used/total). Inside a cgroup v2
+ *        with a lower memory.max, the limit is reported as the total.
  * @return A dynamically allocated string with memory info (e.g., "8.1/15.8 GB"),
  *         or NULL on failure. The caller is responsible for freeing this memory.
  */
 char *get_memory(void);
 
+/**
+ * @brief Used and total RAM in kB, clamped to the cgroup v2 limit like get_memory().
+ * @return 0 on success, -1 if /proc/meminfo is unreadable.
+ */
+int get_ram_usage(unsigned long long *used_kb, unsigned long long *total_kb);
+
+/**
+ * @brief RAM usage in percent, clamped to the cgroup v2 limit like get_memory().
+ * @return A dynamically allocated string (e.g., "53%"). The caller must free it.
+ */
+char *get_ram_percent(void);
+
+/**
+ * @brief Used/total swap (e.g., "0.2/8.0 GB"), or "none".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_swap_str(void);
+
+/**
+ * @brief zram usage with compression ratio (e.g., "1.2/8.0 GB (3.1x)"), or "none".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_zram_str(void);
+
+/**
+ * @brief Used/total huge pages with page size (e.g., "12/512 x 2M"), or "none".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_hugepages_str(void);
+
+enum psi_resource {
+	PSI_CPU,
+	PSI_MEMORY,
+	PSI_IO,
+	PSI_RESOURCES
+};
+
+/* The "some" line of a pressure file. */
+struct psi_stat {
+	double avg10;			/* percent */
+	double avg60;			/* percent */
+	unsigned long long total;	/* stalled microseconds since boot */
+};
+
+/**
+ * @brief Reads one pressure-stall file without allocating. Uses the cgroup's
+ *        own cpu/memory/io.pressure when running inside a cgroup v2.
+ * @return 0 on success, -1 if PSI is unavailable.
+ */
+int psi_read(enum psi_resource res, struct psi_stat *st);
+
+/**
+ * @brief Finds this process's cgroup v2 directory under /sys/fs/cgroup.
+ * @return 0 on success, -1 when cgroup v2 is not mounted or not in use.
+ */
+int cgroup_v2_dir(char *buf, size_t sz);
+
 /**
  * @brief Fetches the resolution and refresh rate of the primary monitor.
  * @return A dynamically allocated string with monitor info, or NULL on failure.
@@ -45,9 +105,172 @@ char *xstrdup(const char *s);
 
 char *get_motherboard(void);
 
+/**
+ * @brief BIOS vendor, version and release date from SMBIOS type 0
+ *        (e.g., "American Megatrends Inc. 2801 (04/27/2022)").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_bios_str(void);
+
+/**
+ * @brief Chassis type and serial number from SMBIOS types 3 and 1
+ *        (e.g., "Notebook, S/N PF3ABCDE"). The serial needs root.
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_chassis_str(void);
+
+/**
+ * @brief Installed memory modules from SMBIOS type 17, grouped
+ *        (e.g., "2x 16 GB DDR4 @ 3200 MT/s"). Needs read access to the raw table.
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_dimms_str(void);
+
+/**
+ * @brief Detects the hypervisor from CPUID leaf 0x40000000, then DMI strings.
+ * @return A dynamically allocated string (e.g., "KVM", "none"). The caller must free it.
+ */
+char *get_virt_str(void);
+
+/**
+ * @brief Detects the container runtime from /proc/1/cgroup and the runtimes'
+ *        marker files.
+ * @return A dynamically allocated string (e.g., "Docker", "none"). The caller must free it.
+ */
+char *get_container_str(void);
+
+/**
+ * @brief Names the init system from /proc/1/comm.
+ * @return A dynamically allocated string (e.g., "systemd"). The caller must free it.
+ */
+char *get_init_str(void);
+
 char *get_disk_info(void);
 
+/**
+ * @brief Lists usage of every real mounted filesystem from /proc/self/mountinfo,
+ *        e.g., "/ 50.1G/236.7G, /home 1.2T/2.0T". statvfs() runs in parallel
+ *        threads with a per-mount timeout, so a dead NFS server shows "(timeout)".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_disks_str(void);
+
+/**
+ * @brief Usage of the filesystem holding path, in the same format as get_disk_info().
+ * @param path Any path on the filesystem (e.g., "/home").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_disk_usage_str(const char *path);
+
+/**
+ * @brief Resolves a PCI vendor/device pair through the system pci.ids file.
+ * @param buf Receives "Vendor Device", or just the vendor if the device is unknown.
+ * @return 0 on success, -1 if the pair is not listed or pci.ids is missing.
+ */
+int pci_ids_lookup(unsigned int vendor, unsigned int device, char *buf, size_t sz);
+
+/**
+ * @brief Lists block devices with model, size and kind from /sys/block,
+ *        e.g., "Samsung SSD 990 PRO 2TB 1.8T (NVMe, fw 4B2QJXD7)".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_storage_str(void);
+
 char *get_cpu_name(void);
 
+#define CPU_CACHE_LEVELS	8
+
+struct cpu_cache_level {
+	int level;		/* 0 when the cache index does not exist */
+	char type;		/* 'd'ata, 'i'nstruction or 'u'nified */
+	long total_kb;		/* size of one instance times the number of instances */
+};
+
+struct cpu_topology {
+	int valid;
+	int threads;
+	int cores;
+	int sockets;
+	int hybrid;		/* Intel hybrid: /sys/devices/cpu_atom exists */
+	int pcores;
+	int ecores;
+	int numa_nodes;		/* 0 when /sys/devices/system/node is absent */
+	struct cpu_cache_level cache[CPU_CACHE_LEVELS];
+};
+
+/**
+ * @brief Probes sockets, cores, threads, caches and NUMA nodes from sysfs.
+ *        The result is computed once per run and cached.
+ * @return A pointer to static storage, or NULL if sysfs is not available.
+ */
+const struct cpu_topology *get_cpu_topology(void);
+
+/**
+ * @brief Formats the per-level cache totals (e.g., "L1d 512K, L2 8M, L3 64M").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_cpu_cache(void);
+
+/**
+ * @brief Formats the CPU name with sockets and core counts,
+ *        e.g., "2x AMD EPYC 7763 (128C/256T)" or "Intel Core i7-1260P (4P+8E/16T)".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_cpu_topology_str(void);
+
+struct cpu_freq {
+	int count;		/* CPUs covered; 0 when nothing could be read */
+	long cur_avg_khz;
+	long cur_max_khz;
+	long min_khz;		/* hardware limits, 0 when only /proc/cpuinfo was available */
+	long max_khz;
+	char governor[64];	/* distinct governors, comma separated */
+};
+
+/**
+ * @brief Reads current/min/max frequencies and governors from cpufreq policies,
+ *        falling back to the "cpu MHz" fields of /proc/cpuinfo.
+ * @return A pointer to static storage, or NULL if no frequency is known.
+ */
+const struct cpu_freq *get_cpu_freq(void);
+
+/**
+ * @brief Formats the frequency, e.g., "1.20 GHz avg, 3.40 GHz max (0.80-4.70 GHz)".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_cpu_freq_str(void);
+
+/**
+ * @brief Returns the scaling governor(s) in use, e.g., "schedutil".
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_governor_str(void);
+
+/**
+ * @brief Reads the CPU package/die temperature from hwmon (e.g., "54.0°C").
+ *        Sensor paths are discovered once and cached per boot.
+ * @return A dynamically allocated string, "unknown" if no sensor was found.
+ */
+char *get_cpu_temp(void);
+
+/**
+ * @brief Reads the GPU temperature from hwmon (amdgpu, radeon, nouveau).
+ * @return A dynamically allocated string, "unknown" if no sensor was found.
+ */
+char *get_gpu_temp(void);
+
+/**
+ * @brief Summarizes system batteries, e.g., "87% (Discharging, 3h 12m left)".
+ * @return A dynamically allocated string, "none" without a battery.
+ */
+char *get_battery_str(void);
+
+/**
+ * @brief Reports the power source and battery draw, e.g., "Battery, 9.8 W".
+ * @return A dynamically allocated string, empty when no power supply is
+ *         exposed (e.g. a VM or container). The caller must free it.
+ */
+char *get_power_str(void);
+
 
 #endif // FETCH_H
\ No newline at end of file
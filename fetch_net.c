@@ -0,0 +1,282 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+/* Files includes. */
+#include "fetch_net.h"
+#include "utils.h"
+
+struct net_iface {
+	int index;
+	unsigned int flags;
+	char name[IF_NAMESIZE];
+	char kind[16];
+	char ipv4[INET6_ADDRSTRLEN + 5];
+	char ipv6[INET6_ADDRSTRLEN + 5];
+	int shown;
+};
+
+static struct net_iface *ifaces;
+static size_t iface_count;
+static int probed;
+
+static char *ignore_names;
+static char *ignore_kinds;
+
+void net_probe_configure(const char *names, const char *kinds)
+{
+	free(ignore_names);
+	free(ignore_kinds);
+	ignore_names = names ? xstrdup(names) : NULL;
+	ignore_kinds = kinds ? xstrdup(kinds) : NULL;
+}
+
+static int list_matches(const char *list, const char *s, int glob)
+{
+	char item[64];
+	const char *p = list;
+
+	if (!list || !*s)
+		return 0;
+	while (*p) {
+		size_t n = strcspn(p, ",");
+
+		if (n > 0 && n < sizeof(item)) {
+			char *t = item;
+
+			memcpy(item, p, n);
+			item[n] = '\0';
+			t = ltrim(item);
+			rtrim_inplace(t);
+			if (glob ? fnmatch(t, s, 0) == 0 : strcmp(t, s) == 0)
+				return 1;
+		}
+		p += n;
+		if (*p == ',')
+			p++;
+	}
+	return 0;
+}
+
+static int iface_filtered(const struct net_iface *nif)
+{
+	return (nif->flags & IFF_LOOPBACK) || list_matches(ignore_names, nif->name, 1) ||
+	       list_matches(ignore_kinds, nif->kind, 0);
+}
+
+static struct net_iface *iface_by_index(int index)
+{
+	size_t i;
+
+	for (i = 0; i < iface_count; i++)
+		if (ifaces[i].index == index)
+			return &ifaces[i];
+	return NULL;
+}
+
+static void parse_link(struct nlmsghdr *nh)
+{
+	struct ifinfomsg *ifi = NLMSG_DATA(nh);
+	struct rtattr *rta = IFLA_RTA(ifi);
+	int len = (int)IFLA_PAYLOAD(nh);
+	struct net_iface *nif, *tmp;
+
+	tmp = realloc(ifaces, sizeof(*ifaces) * (iface_count + 1));
+	if (!tmp)
+		return;
+	ifaces = tmp;
+	nif = &ifaces[iface_count];
+	memset(nif, 0, sizeof(*nif));
+	nif->index = ifi->ifi_index;
+	nif->flags = ifi->ifi_flags;
+
+	for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		if (rta->rta_type == IFLA_IFNAME) {
+			snprintf(nif->name, sizeof(nif->name), "%s", (char *)RTA_DATA(rta));
+		} else if (rta->rta_type == IFLA_LINKINFO) {
+			struct rtattr *li = RTA_DATA(rta);
+			int lilen = (int)RTA_PAYLOAD(rta);
+
+			for (; RTA_OK(li, lilen); li = RTA_NEXT(li, lilen))
+				if (li->rta_type == IFLA_INFO_KIND)
+					snprintf(nif->kind, sizeof(nif->kind), "%s", (char *)RTA_DATA(li));
+		}
+	}
+	iface_count++;
+}
+
+static void parse_addr(struct nlmsghdr *nh)
+{
+	struct ifaddrmsg *ifa = NLMSG_DATA(nh);
+	struct rtattr *rta = IFA_RTA(ifa);
+	int len = (int)IFA_PAYLOAD(nh);
+	struct net_iface *nif = iface_by_index((int)ifa->ifa_index);
+	const void *addr = NULL;
+	char text[INET6_ADDRSTRLEN];
+
+	if (!nif || ifa->ifa_scope != RT_SCOPE_UNIVERSE)
+		return;
+	for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		/* IFA_LOCAL is the interface's own address on point-to-point links. */
+		if (rta->rta_type == IFA_LOCAL || (rta->rta_type == IFA_ADDRESS && !addr))
+			addr = RTA_DATA(rta);
+	}
+	if (!addr || !inet_ntop(ifa->ifa_family, addr, text, sizeof(text)))
+		return;
+	if (ifa->ifa_family == AF_INET && !nif->ipv4[0])
+		snprintf(nif->ipv4, sizeof(nif->ipv4), "%s/%u", text, ifa->ifa_prefixlen);
+	else if (ifa->ifa_family == AF_INET6 && !nif->ipv6[0])
+		snprintf(nif->ipv6, sizeof(nif->ipv6), "%s/%u", text, ifa->ifa_prefixlen);
+}
+
+/* Sends a dump request and hands every reply of reply_type to cb. */
+static int netlink_dump(int fd, int type, int reply_type, void (*cb)(struct nlmsghdr *))
+{
+	struct {
+		struct nlmsghdr nh;
+		struct rtgenmsg g;
+	} req;
+	struct sockaddr_nl sa = { .nl_family = AF_NETLINK };
+	char buf[32768];
+
+	memset(&req, 0, sizeof(req));
+	req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(req.g));
+	req.nh.nlmsg_type = (unsigned short)type;
+	req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.nh.nlmsg_seq = (unsigned int)type;
+	req.g.rtgen_family = AF_UNSPEC;
+	if (sendto(fd, &req, req.nh.nlmsg_len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+		return -1;
+
+	for (;;) {
+		ssize_t n = recv(fd, buf, sizeof(buf), 0);
+		struct nlmsghdr *nh;
+		int len;
+
+		if (n <= 0)
+			return -1;
+		len = (int)n;
+		for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+			if (nh->nlmsg_type == NLMSG_DONE)
+				return 0;
+			if (nh->nlmsg_type == NLMSG_ERROR)
+				return -1;
+			if (nh->nlmsg_type == reply_type)
+				cb(nh);
+		}
+	}
+}
+
+static void net_probe(void)
+{
+	int fd;
+	size_t i;
+
+	if (probed)
+		return;
+	probed = 1;
+	fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		return;
+	if (netlink_dump(fd, RTM_GETLINK, RTM_NEWLINK, parse_link) == 0)
+		netlink_dump(fd, RTM_GETADDR, RTM_NEWADDR, parse_addr);
+	close(fd);
+
+	for (i = 0; i < iface_count; i++) {
+		struct net_iface *nif = &ifaces[i];
+
+		nif->shown = !iface_filtered(nif) && (nif->flags & IFF_UP);
+	}
+	debug_log("net: %zu interfaces from netlink", iface_count);
+}
+
+int net_iface_ignored(const char *name)
+{
+	size_t i;
+
+	net_probe();
+	for (i = 0; i < iface_count; i++)
+		if (!strcmp(ifaces[i].name, name))
+			return iface_filtered(&ifaces[i]);
+	return list_matches(ignore_names, name, 1);
+}
+
+void net_probe_free(void)
+{
+	free(ifaces);
+	free(ignore_names);
+	free(ignore_kinds);
+	ifaces = NULL;
+	ignore_names = NULL;
+	ignore_kinds = NULL;
+	iface_count = 0;
+	probed = 0;
+}
+
+char *get_ip_str(void)
+{
+	size_t i;
+
+	net_probe();
+	for (i = 0; i < iface_count; i++)
+		if (ifaces[i].shown && ifaces[i].ipv4[0])
+			return xstrdup(ifaces[i].ipv4);
+	for (i = 0; i < iface_count; i++)
+		if (ifaces[i].shown && ifaces[i].ipv6[0])
+			return xstrdup(ifaces[i].ipv6);
+	return xstrdup("offline");
+}
+
+char *get_ifaces_str(void)
+{
+	char buf[512];
+	size_t i, len = 0;
+
+	net_probe();
+	buf[0] = '\0';
+	for (i = 0; i < iface_count && len < sizeof(buf); i++) {
+		if (!ifaces[i].shown)
+			continue;
+		len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s%s",
+					len ? ", " : "", ifaces[i].name);
+	}
+	return xstrdup(len ? buf : "none");
+}
+
+char *get_link_speed_str(void)
+{
+	char buf[512];
+	size_t i, len = 0;
+
+	net_probe();
+	buf[0] = '\0';
+	for (i = 0; i < iface_count && len < sizeof(buf); i++) {
+		char path[64];
+		long mbps;
+
+		if (!ifaces[i].shown)
+			continue;
+		snprintf(path, sizeof(path), "/sys/class/net/%s/speed", ifaces[i].name);
+		mbps = read_long_at(AT_FDCWD, path, -1);
+		if (mbps <= 0)
+			continue;
+		if (mbps >= 1000 && mbps % 1000 == 0)
+			len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s%s %ld Gb/s",
+						len ? ", " : "", ifaces[i].name, mbps / 1000);
+		else
+			len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s%s %ld Mb/s",
+						len ? ", " : "", ifaces[i].name, mbps);
+	}
+	return xstrdup(len ? buf : "unknown");
+}
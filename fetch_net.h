@@ -0,0 +1,57 @@
+#ifndef FETCH_NET_H
+#define FETCH_NET_H
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  fetch_net.h
+ *
+ *    Description:  Network interface probe built on one RTM_GETLINK and one
+ *                  RTM_GETADDR netlink dump. Works offline and inside network
+ *                  namespaces, never forks.
+ *
+ * =====================================================================================
+ */
+
+/**
+ * @brief Sets the interface filter rules. Loopback is always hidden.
+ * @param ignore_names Comma-separated glob patterns matched against interface
+ *        names (e.g., "veth*,docker*"), or NULL for none.
+ * @param ignore_kinds Comma-separated link kinds from IFLA_INFO_KIND
+ *        (e.g., "bridge,veth,tun"), or NULL for none.
+ */
+void net_probe_configure(const char *ignore_names, const char *ignore_kinds);
+
+/**
+ * @brief Tells whether an interface is hidden by the filter rules: loopback,
+ *        an ignored name, or an ignored link kind. Probes on first use.
+ * @return 1 if ignored, 0 otherwise.
+ */
+int net_iface_ignored(const char *name);
+
+/**
+ * @brief Frees the interface list and the filter rules.
+ */
+void net_probe_free(void);
+
+/**
+ * @brief Returns the first address of the first shown interface, IPv4 preferred
+ *        (e.g., "192.168.1.20/24").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_ip_str(void);
+
+/**
+ * @brief Lists the shown interfaces that are up (e.g., "enp3s0, wlan0").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_ifaces_str(void);
+
+/**
+ * @brief Link speed of the shown interfaces (e.g., "enp3s0 1 Gb/s").
+ *        /sys/class/net/<iface>/speed is read only for those interfaces.
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_link_speed_str(void);
+
+#endif // FETCH_NET_H
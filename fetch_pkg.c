@@ -0,0 +1,630 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+/* Files includes. */
+#include "fetch_pkg.h"
+#include "fetch_sw.h"
+#include "utils.h"
+
+#define PACMAN_LOCAL	"/var/lib/pacman/local"
+#define PACMAN_SYNC	"/var/lib/pacman/sync"
+#define DPKG_STATUS	"/var/lib/dpkg/status"
+#define APT_LISTS	"/var/lib/apt/lists"
+
+#define TAR_BLOCK	512
+
+static const struct {
+	const char *id;
+	enum pkg_family family;
+} pkg_families[] = {
+	{ "arch",	PKG_PACMAN },
+	{ "archlinux",	PKG_PACMAN },
+	{ "debian",	PKG_DPKG },
+	{ "ubuntu",	PKG_DPKG },
+	{ "fedora",	PKG_RPM },
+	{ "rhel",	PKG_RPM },
+	{ "redhat",	PKG_RPM },
+	{ NULL,		PKG_NONE }
+};
+
+enum pkg_family pkg_family_of(const char *id)
+{
+	int i;
+
+	if (!id)
+		return PKG_NONE;
+	for (i = 0; pkg_families[i].id; i++)
+		if (!strcmp(id, pkg_families[i].id))
+			return pkg_families[i].family;
+	return PKG_NONE;
+}
+
+enum pkg_family pkg_family_detect(void)
+{
+	const struct os_release *os = get_os_release();
+	enum pkg_family fam;
+	const char *like;
+	char word[64];
+
+	if (!os)
+		return PKG_NONE;
+	fam = pkg_family_of(os->id);
+	like = os->id_like;
+	while (fam == PKG_NONE && os_release_next_like(&like, word, sizeof(word)))
+		fam = pkg_family_of(word);
+	return fam;
+}
+
+/*
+ * rpmvercmp as used by pacman: alternating runs of digits and letters are
+ * compared numerically or lexically, and a numeric run beats an alpha one.
+ */
+static int rpmvercmp(const char *a, const char *b)
+{
+	const char *one = a, *two = b;
+
+	if (!strcmp(a, b))
+		return 0;
+	while (*one && *two) {
+		const char *p1, *p2;
+		size_t n1, n2;
+		int isnum, rc;
+
+		while (*one && !isalnum((unsigned char)*one))
+			one++;
+		while (*two && !isalnum((unsigned char)*two))
+			two++;
+		if (!*one || !*two)
+			break;
+		p1 = one;
+		p2 = two;
+		isnum = isdigit((unsigned char)*p1) != 0;
+		if (isnum) {
+			while (isdigit((unsigned char)*one))
+				one++;
+			while (isdigit((unsigned char)*two))
+				two++;
+		} else {
+			while (isalpha((unsigned char)*one))
+				one++;
+			while (isalpha((unsigned char)*two))
+				two++;
+		}
+		if (two == p2)
+			return isnum ? 1 : -1;
+		if (isnum) {
+			while (*p1 == '0' && p1 < one - 1)
+				p1++;
+			while (*p2 == '0' && p2 < two - 1)
+				p2++;
+			if (one - p1 != two - p2)
+				return one - p1 > two - p2 ? 1 : -1;
+		}
+		n1 = (size_t)(one - p1);
+		n2 = (size_t)(two - p2);
+		rc = strncmp(p1, p2, n1 < n2 ? n1 : n2);
+		if (rc)
+			return rc < 0 ? -1 : 1;
+		if (n1 != n2)
+			return n1 > n2 ? 1 : -1;
+	}
+	if (!*one && !*two)
+		return 0;
+	/* Trailing letters mark a pre-release: "1.0a" < "1.0" < "1.0.1". */
+	return (!*one && !isalpha((unsigned char)*two)) || isalpha((unsigned char)*one) ? -1 : 1;
+}
+
+/* Splits [epoch:]version[-release] in place. */
+static void split_evr(char *evr, const char **epoch, const char **ver, const char **rel)
+{
+	char *s = evr, *dash;
+
+	while (isdigit((unsigned char)*s))
+		s++;
+	if (*s == ':') {
+		*s = '\0';
+		*epoch = evr;
+		*ver = s + 1;
+	} else {
+		*epoch = "0";
+		*ver = evr;
+	}
+	dash = strrchr(*ver, '-');
+	if (dash) {
+		*dash = '\0';
+		*rel = dash + 1;
+	} else {
+		*rel = NULL;
+	}
+}
+
+int pkg_vercmp_alpm(const char *a, const char *b)
+{
+	char x[256], y[256];
+	const char *e1, *v1, *r1, *e2, *v2, *r2;
+	int rc;
+
+	snprintf(x, sizeof(x), "%s", a);
+	snprintf(y, sizeof(y), "%s", b);
+	split_evr(x, &e1, &v1, &r1);
+	split_evr(y, &e2, &v2, &r2);
+	rc = rpmvercmp(e1, e2);
+	if (rc == 0)
+		rc = rpmvercmp(v1, v2);
+	if (rc == 0 && r1 && r2)
+		rc = rpmvercmp(r1, r2);
+	return rc;
+}
+
+static int deb_order(int c)
+{
+	if (isdigit(c))
+		return 0;
+	if (isalpha(c))
+		return c;
+	if (c == '~')
+		return -1;
+	if (c)
+		return c + 256;
+	return 0;
+}
+
+/* dpkg's verrevcmp: '~' sorts before everything, even the end of the string. */
+static int deb_verrevcmp(const char *a, const char *b)
+{
+	while (*a || *b) {
+		int first_diff = 0;
+
+		while ((*a && !isdigit((unsigned char)*a)) || (*b && !isdigit((unsigned char)*b))) {
+			int ac = deb_order((unsigned char)*a);
+			int bc = deb_order((unsigned char)*b);
+
+			if (ac != bc)
+				return ac - bc;
+			a++;
+			b++;
+		}
+		while (*a == '0')
+			a++;
+		while (*b == '0')
+			b++;
+		while (isdigit((unsigned char)*a) && isdigit((unsigned char)*b)) {
+			if (!first_diff)
+				first_diff = *a - *b;
+			a++;
+			b++;
+		}
+		if (isdigit((unsigned char)*a))
+			return 1;
+		if (isdigit((unsigned char)*b))
+			return -1;
+		if (first_diff)
+			return first_diff;
+	}
+	return 0;
+}
+
+int pkg_vercmp_deb(const char *a, const char *b)
+{
+	char x[256], y[256];
+	const char *e1, *v1, *r1, *e2, *v2, *r2;
+	long d;
+	int rc;
+
+	snprintf(x, sizeof(x), "%s", a);
+	snprintf(y, sizeof(y), "%s", b);
+	split_evr(x, &e1, &v1, &r1);
+	split_evr(y, &e2, &v2, &r2);
+	d = strtol(e1, NULL, 10) - strtol(e2, NULL, 10);
+	if (d)
+		return d < 0 ? -1 : 1;
+	rc = deb_verrevcmp(v1, v2);
+	if (rc == 0)
+		rc = deb_verrevcmp(r1 ? r1 : "", r2 ? r2 : "");
+	return rc;
+}
+
+/* Open-addressing table of installed packages: key -> version. */
+struct pkg_entry {
+	char *key;
+	char *version;
+	int counted;
+};
+
+struct pkg_table {
+	struct pkg_entry *slots;
+	size_t cap;
+	size_t count;
+};
+
+static unsigned long long fnv1a(const void *data, size_t n, unsigned long long h)
+{
+	const unsigned char *p = data;
+
+	while (n--) {
+		h ^= *p++;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+#define FNV_OFFSET	14695981039346656037ULL
+
+static struct pkg_entry *table_slot(const struct pkg_table *t, const char *key, size_t n)
+{
+	size_t i = (size_t)fnv1a(key, n, FNV_OFFSET) & (t->cap - 1);
+
+	while (t->slots[i].key &&
+	       (strncmp(t->slots[i].key, key, n) != 0 || t->slots[i].key[n] != '\0'))
+		i = (i + 1) & (t->cap - 1);
+	return &t->slots[i];
+}
+
+static struct pkg_entry *table_find(const struct pkg_table *t, const char *key, size_t n)
+{
+	struct pkg_entry *e;
+
+	if (!t->cap)
+		return NULL;
+	e = table_slot(t, key, n);
+	return e->key ? e : NULL;
+}
+
+static int table_grow(struct pkg_table *t)
+{
+	struct pkg_table bigger;
+	size_t i;
+
+	bigger.cap = t->cap ? t->cap * 2 : 1024;
+	bigger.count = t->count;
+	bigger.slots = calloc(bigger.cap, sizeof(*bigger.slots));
+	if (!bigger.slots)
+		return -1;
+	for (i = 0; i < t->cap; i++)
+		if (t->slots[i].key)
+			*table_slot(&bigger, t->slots[i].key, strlen(t->slots[i].key)) = t->slots[i];
+	free(t->slots);
+	*t = bigger;
+	return 0;
+}
+
+static void table_put(struct pkg_table *t, const char *key, size_t kn, const char *ver, size_t vn)
+{
+	struct pkg_entry *e;
+
+	if ((t->count + 1) * 10 > t->cap * 7 && table_grow(t) != 0)
+		return;
+	e = table_slot(t, key, kn);
+	if (e->key)
+		return;
+	e->key = strndup(key, kn);
+	e->version = strndup(ver, vn);
+	if (!e->key || !e->version) {
+		free(e->key);
+		free(e->version);
+		e->key = NULL;
+		return;
+	}
+	t->count++;
+}
+
+static void table_free(struct pkg_table *t)
+{
+	size_t i;
+
+	for (i = 0; i < t->cap; i++) {
+		free(t->slots[i].key);
+		free(t->slots[i].version);
+	}
+	free(t->slots);
+	memset(t, 0, sizeof(*t));
+}
+
+/* "name-pkgver-pkgrel": the name may contain dashes, the last two fields may not. */
+static int split_pacman_dir(const char *s, size_t len, size_t *name_len)
+{
+	const char *end = s + len;
+	const char *p = end;
+	int dashes = 0;
+
+	while (p > s) {
+		p--;
+		if (*p == '-' && ++dashes == 2) {
+			*name_len = (size_t)(p - s);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static void pacman_installed(struct pkg_table *t)
+{
+	DIR *d = opendir(PACMAN_LOCAL);
+	struct dirent *de;
+
+	if (!d)
+		return;
+	while ((de = readdir(d)) != NULL) {
+		size_t len = strlen(de->d_name), nlen;
+
+		if (de->d_name[0] == '.' || split_pacman_dir(de->d_name, len, &nlen) != 0)
+			continue;
+		table_put(t, de->d_name, nlen, de->d_name + nlen + 1, len - nlen - 1);
+	}
+	closedir(d);
+}
+
+static void pacman_entry(struct pkg_table *t, const char *path, long *count)
+{
+	size_t len = strlen(path), nlen;
+	struct pkg_entry *e;
+	char ver[256];
+
+	/* Every package has a "<dir>/desc" member; directory entries are optional. */
+	if (len < 6 || strcmp(path + len - 5, "/desc") != 0)
+		return;
+	len -= 5;
+	if (split_pacman_dir(path, len, &nlen) != 0)
+		return;
+	e = table_find(t, path, nlen);
+	if (!e || e->counted)
+		return;
+	snprintf(ver, sizeof(ver), "%.*s", (int)(len - nlen - 1), path + nlen + 1);
+	if (pkg_vercmp_alpm(ver, e->version) > 0) {
+		e->counted = 1;
+		(*count)++;
+	}
+}
+
+/*
+ * Streams one sync database (a gzip'd or plain tar) and looks only at the
+ * member names. Long names arrive in pax ('x') or GNU ('L') records.
+ */
+static void pacman_sync_db(struct pkg_table *t, const char *db, long *count)
+{
+	unsigned char h[TAR_BLOCK];
+	char longname[512] = "";
+	gzFile gz;
+
+	gz = gzopen(db, "rb");
+	if (!gz)
+		return;
+	gzbuffer(gz, 128 * 1024);
+	while (gzread(gz, h, TAR_BLOCK) == TAR_BLOCK && h[0]) {
+		char name[512];
+		unsigned long size = strtoul((const char *)h + 124, NULL, 8);
+		unsigned long padded = (size + TAR_BLOCK - 1) & ~(unsigned long)(TAR_BLOCK - 1);
+		char type = (char)h[156];
+
+		if (memcmp(h + 257, "ustar", 5) != 0) {
+			debug_log("updates: %s is not a gzip or plain tar, skipped", db);
+			break;
+		}
+		if ((type == 'x' || type == 'L') && size < sizeof(longname)) {
+			char rec[512];
+
+			if (gzread(gz, rec, (unsigned int)padded) != (int)padded)
+				break;
+			rec[size] = '\0';
+			if (type == 'L') {
+				snprintf(longname, sizeof(longname), "%s", rec);
+			} else {
+				char *p = strstr(rec, " path=");
+
+				if (p)
+					snprintf(longname, sizeof(longname), "%.*s",
+						 (int)strcspn(p + 6, "\n"), p + 6);
+			}
+			continue;
+		}
+		if (longname[0]) {
+			snprintf(name, sizeof(name), "%s", longname);
+			longname[0] = '\0';
+		} else if (h[345]) {
+			snprintf(name, sizeof(name), "%.155s/%.100s", (const char *)h + 345, (const char *)h);
+		} else {
+			snprintf(name, sizeof(name), "%.100s", (const char *)h);
+		}
+		pacman_entry(t, name, count);
+		if (padded && gzseek(gz, (z_off_t)padded, SEEK_CUR) < 0)
+			break;
+	}
+	gzclose(gz);
+}
+
+/* Status lines are "want flag status"; only fully installed packages count. */
+static void dpkg_installed(struct pkg_table *t)
+{
+	char *buf = read_file_alloc(DPKG_STATUS, NULL);
+	char *line, *save = NULL;
+	char pkg[128] = "", arch[32] = "", ver[256] = "";
+	int installed = 0;
+
+	if (!buf)
+		return;
+	for (line = strtok_r(buf, "\n", &save); ; line = strtok_r(NULL, "\n", &save)) {
+		/* strtok_r skips blank lines, so a paragraph ends at the next "Package:". */
+		if (!line || !strncmp(line, "Package: ", 9)) {
+			if (pkg[0] && installed && ver[0]) {
+				char key[192];
+				int n = snprintf(key, sizeof(key), "%s:%s", pkg, arch);
+
+				table_put(t, key, (size_t)n, ver, strlen(ver));
+			}
+			if (!line)
+				break;
+			snprintf(pkg, sizeof(pkg), "%s", line + 9);
+			arch[0] = ver[0] = '\0';
+			installed = 0;
+		} else if (!strncmp(line, "Status: ", 8)) {
+			size_t n = strlen(line);
+
+			installed = n >= 10 && !strcmp(line + n - 10, " installed");
+		} else if (!strncmp(line, "Architecture: ", 14)) {
+			snprintf(arch, sizeof(arch), "%s", line + 14);
+		} else if (!strncmp(line, "Version: ", 9)) {
+			snprintf(ver, sizeof(ver), "%s", line + 9);
+		}
+	}
+	free(buf);
+}
+
+static void apt_candidate(struct pkg_table *t, const char *pkg, const char *arch,
+			  const char *ver, long *count)
+{
+	char key[192];
+	int n;
+	struct pkg_entry *e;
+
+	if (!pkg[0] || !ver[0])
+		return;
+	n = snprintf(key, sizeof(key), "%s:%s", pkg, arch);
+	e = table_find(t, key, (size_t)n);
+	if (e && !e->counted && pkg_vercmp_deb(ver, e->version) > 0) {
+		e->counted = 1;
+		(*count)++;
+	}
+}
+
+/*
+ * Streams one Packages index, plain or gzip'd. Description lines can be longer
+ * than the buffer, so only chunks that start a line are looked at.
+ */
+static void apt_list(struct pkg_table *t, const char *path, long *count)
+{
+	char line[4096];
+	char pkg[128] = "", arch[32] = "", ver[256] = "";
+	int at_start = 1;
+	gzFile gz;
+
+	gz = gzopen(path, "rb");
+	if (!gz)
+		return;
+	gzbuffer(gz, 128 * 1024);
+	while (gzgets(gz, line, sizeof(line))) {
+		size_t n = strlen(line);
+		int starts = at_start;
+
+		at_start = n > 0 && line[n - 1] == '\n';
+		if (!starts)
+			continue;
+		if (at_start)
+			line[--n] = '\0';
+		if (n == 0) {
+			apt_candidate(t, pkg, arch, ver, count);
+			pkg[0] = arch[0] = ver[0] = '\0';
+		} else if (!strncmp(line, "Package: ", 9)) {
+			snprintf(pkg, sizeof(pkg), "%s", line + 9);
+		} else if (!strncmp(line, "Architecture: ", 14)) {
+			snprintf(arch, sizeof(arch), "%s", line + 14);
+		} else if (!strncmp(line, "Version: ", 9)) {
+			snprintf(ver, sizeof(ver), "%s", line + 9);
+		}
+	}
+	apt_candidate(t, pkg, arch, ver, count);
+	gzclose(gz);
+}
+
+static int apt_list_name(const char *path)
+{
+	size_t n = strlen(path);
+
+	return (n > 9 && !strcmp(path + n - 9, "_Packages")) ||
+	       (n > 12 && !strcmp(path + n - 12, "_Packages.gz"));
+}
+
+/* Any install, removal or sync refresh changes one of these mtimes. */
+static unsigned long long sources_key(const char *installed, const glob_t *gl)
+{
+	unsigned long long h = FNV_OFFSET;
+	struct stat st;
+	size_t i;
+
+	for (i = 0; i <= gl->gl_pathc; i++) {
+		const char *path = i == 0 ? installed : gl->gl_pathv[i - 1];
+		long long v[3] = { 0, 0, 0 };
+
+		if (stat(path, &st) == 0) {
+			v[0] = (long long)st.st_mtim.tv_sec;
+			v[1] = (long long)st.st_mtim.tv_nsec;
+			v[2] = (long long)st.st_size;
+		}
+		h = fnv1a(path, strlen(path), h);
+		h = fnv1a(v, sizeof(v), h);
+	}
+	return h;
+}
+
+static int updates_cache_lookup(const char *key, long *count)
+{
+	char cached[96];
+	char *tab;
+
+	if (cache_read("updates", cached, sizeof(cached)) != 0)
+		return -1;
+	tab = strchr(cached, '\t');
+	if (!tab)
+		return -1;
+	*tab = '\0';
+	if (strcmp(cached, key) != 0)
+		return -1;
+	*count = strtol(tab + 1, NULL, 10);
+	return 0;
+}
+
+char *get_updates_str(void)
+{
+	enum pkg_family fam = pkg_family_detect();
+	struct pkg_table t = { NULL, 0, 0 };
+	const char *installed;
+	char key[32];
+	char buf[96];
+	glob_t gl;
+	long count = 0;
+	size_t i;
+
+	if (fam == PKG_PACMAN) {
+		installed = PACMAN_LOCAL;
+		if (glob(PACMAN_SYNC "/*.db", 0, NULL, &gl) != 0)
+			return xstrdup("unknown");
+	} else if (fam == PKG_DPKG) {
+		installed = DPKG_STATUS;
+		if (glob(APT_LISTS "/*_Packages*", 0, NULL, &gl) != 0)
+			return xstrdup("unknown");
+	} else {
+		return xstrdup("unknown");
+	}
+
+	snprintf(key, sizeof(key), "%016llx", sources_key(installed, &gl));
+	if (updates_cache_lookup(key, &count) != 0) {
+		if (fam == PKG_PACMAN) {
+			pacman_installed(&t);
+			for (i = 0; i < gl.gl_pathc; i++)
+				pacman_sync_db(&t, gl.gl_pathv[i], &count);
+		} else {
+			dpkg_installed(&t);
+			for (i = 0; i < gl.gl_pathc; i++)
+				if (apt_list_name(gl.gl_pathv[i]))
+					apt_list(&t, gl.gl_pathv[i], &count);
+		}
+		debug_log("updates: %zu installed, %zu databases, %ld newer",
+			  t.count, gl.gl_pathc, count);
+		table_free(&t);
+		snprintf(buf, sizeof(buf), "%s\t%ld\n", key, count);
+		cache_write("updates", buf);
+	}
+	globfree(&gl);
+
+	if (count == 0)
+		return xstrdup("up to date");
+	snprintf(buf, sizeof(buf), "%ld update%s", count, count == 1 ? "" : "s");
+	return xstrdup(buf);
+}
@@ -0,0 +1,56 @@
+#ifndef FETCH_PKG_H
+#define FETCH_PKG_H
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  fetch_pkg.h
+ *
+ *    Description:  Package manager detection and an offline pending-update count.
+ *                  The installed set is compared against the sync databases
+ *                  already on disk; nothing is downloaded and nothing is forked.
+ *
+ * =====================================================================================
+ */
+
+enum pkg_family {
+	PKG_NONE,
+	PKG_PACMAN,
+	PKG_DPKG,
+	PKG_RPM
+};
+
+/**
+ * @brief Maps an os-release ID (e.g., "arch", "ubuntu") to its package manager.
+ * @return The family, or PKG_NONE for unknown IDs.
+ */
+enum pkg_family pkg_family_of(const char *id);
+
+/**
+ * @brief Resolves the package manager from os-release ID, then each ID_LIKE entry.
+ * @return The family, or PKG_NONE.
+ */
+enum pkg_family pkg_family_detect(void);
+
+/**
+ * @brief Compares two pacman/rpm style versions ([epoch:]pkgver[-pkgrel]).
+ * @return <0, 0 or >0 like strcmp.
+ */
+int pkg_vercmp_alpm(const char *a, const char *b);
+
+/**
+ * @brief Compares two Debian versions ([epoch:]upstream[-revision]), '~' sorting first.
+ * @return <0, 0 or >0 like strcmp.
+ */
+int pkg_vercmp_deb(const char *a, const char *b);
+
+/**
+ * @brief Number of installed packages with a newer version in the local sync
+ *        databases (pacman sync/<repo>.db or apt lists/<source>_Packages). The result is
+ *        cached until one of those files changes.
+ * @return A dynamically allocated string (e.g., "12 updates", "up to date").
+ *         The caller must free it.
+ */
+char *get_updates_str(void);
+
+#endif // FETCH_PKG_H
@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/* Files includes. */
+#include "fetch_proc.h"
+#include "utils.h"
+
+/* glibc only wraps getdents64 since 2.30, so the syscall is used directly. */
+struct linux_dirent64 {
+	unsigned long long d_ino;
+	long long d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+enum {
+	PROC_WANT_WM	= 1 << 0,
+	PROC_WANT_COUNT	= 1 << 1,
+	PROC_WANT_TOP	= 1 << 2,
+};
+
+#define PF_KTHREAD	0x00200000
+
+struct proc_top {
+	char comm[16];
+	double val;
+};
+
+/* comm is truncated to 15 bytes by the kernel; prefix entries cover longer names. */
+static const struct {
+	const char *comm;
+	const char *name;
+	int prefix;
+} wm_table[] = {
+	{ "kwin_wayland",	"KWin",		0 },
+	{ "kwin_x11",		"KWin",		0 },
+	{ "gnome-shell",	"Mutter",	0 },
+	{ "mutter",		"Mutter",	0 },
+	{ "Hyprland",		"Hyprland",	0 },
+	{ "sway",		"Sway",		0 },
+	{ "river",		"River",	0 },
+	{ "wayfire",		"Wayfire",	0 },
+	{ "labwc",		"labwc",	0 },
+	{ "niri",		"niri",		0 },
+	{ "weston",		"Weston",	0 },
+	{ "gamescope",		"Gamescope",	0 },
+	{ "xfwm4",		"Xfwm4",	0 },
+	{ "marco",		"Marco",	0 },
+	{ "muffin",		"Muffin",	0 },
+	{ "openbox",		"Openbox",	0 },
+	{ "fluxbox",		"Fluxbox",	0 },
+	{ "icewm",		"IceWM",	0 },
+	{ "i3",			"i3",		0 },
+	{ "bspwm",		"bspwm",	0 },
+	{ "dwm",		"dwm",		0 },
+	{ "awesome",		"awesome",	0 },
+	{ "herbstluftwm",	"herbstluftwm",	0 },
+	{ "qtile",		"Qtile",	0 },
+	{ "xmonad",		"xmonad",	1 },
+	{ "enlightenment",	"Enlightenment", 1 },
+};
+
+static unsigned int done;
+static const char *wm_name;
+static long process_count;
+static struct proc_top top_mem[PROC_TOP_K];
+static struct proc_top top_cpu[PROC_TOP_K];
+static size_t top_mem_n, top_cpu_n;
+
+static const char *wm_match(const char *comm)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(wm_table) / sizeof(wm_table[0]); i++) {
+		size_t n = strlen(wm_table[i].comm);
+
+		if (strncmp(comm, wm_table[i].comm, n) == 0 &&
+		    (comm[n] == '\0' || wm_table[i].prefix))
+			return wm_table[i].name;
+	}
+	return NULL;
+}
+
+/* Bounded min-heap: the root is the smallest of the K largest values seen. */
+static void top_push(struct proc_top *heap, size_t *n, const char *comm, double val)
+{
+	struct proc_top e;
+	size_t i;
+
+	snprintf(e.comm, sizeof(e.comm), "%s", comm);
+	e.val = val;
+	if (*n < PROC_TOP_K) {
+		i = (*n)++;
+		heap[i] = e;
+		while (i > 0 && heap[(i - 1) / 2].val > heap[i].val) {
+			struct proc_top t = heap[i];
+
+			heap[i] = heap[(i - 1) / 2];
+			heap[(i - 1) / 2] = t;
+			i = (i - 1) / 2;
+		}
+		return;
+	}
+	if (val <= heap[0].val)
+		return;
+	heap[0] = e;
+	for (i = 0;;) {
+		size_t l = 2 * i + 1, r = l + 1, m = i;
+		struct proc_top t;
+
+		if (l < *n && heap[l].val < heap[m].val)
+			m = l;
+		if (r < *n && heap[r].val < heap[m].val)
+			m = r;
+		if (m == i)
+			break;
+		t = heap[i];
+		heap[i] = heap[m];
+		heap[m] = t;
+		i = m;
+	}
+}
+
+/*
+ * Pulls comm, flags, utime+stime, starttime and rss out of /proc/<pid>/stat.
+ * comm may contain spaces and parentheses, so it ends at the last ')'.
+ */
+static int parse_stat(char *buf, char *comm, size_t csz, unsigned long *flags,
+		      unsigned long long *ticks, unsigned long long *start, unsigned long long *rss)
+{
+	char *lp = strchr(buf, '(');
+	char *rp = strrchr(buf, ')');
+	char *p;
+	int field;
+
+	if (!lp || !rp || rp < lp || rp[1] != ' ')
+		return -1;
+	snprintf(comm, csz, "%.*s", (int)(rp - lp - 1), lp + 1);
+	*ticks = 0;
+	p = strchr(rp + 2, ' ');
+	for (field = 4; p && *p && field <= 24; field++) {
+		unsigned long long v = strtoull(p, &p, 10);
+
+		if (field == 9)
+			*flags = (unsigned long)v;
+		else if (field == 14 || field == 15)
+			*ticks += v;
+		else if (field == 22)
+			*start = v;
+		else if (field == 24)
+			*rss = v;
+	}
+	return field > 24 ? 0 : -1;
+}
+
+/*
+ * Walks /proc once. A WM-only scan reads just comm and stops at the first
+ * known window manager; a scan for top consumers reads stat, which carries
+ * comm as well, so every PID still costs a single read.
+ */
+static void proc_scan(unsigned int want)
+{
+	char buf[32768];
+	char path[64];
+	char data[1024];
+	double uptime = 0;
+	long clk, page;
+	long n;
+	int fd, stopped = 0;
+	long count = 0;
+
+	want &= ~done;
+	if (!want)
+		return;
+	if (want & PROC_WANT_TOP)
+		want |= PROC_WANT_COUNT;
+	fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	clk = sysconf(_SC_CLK_TCK);
+	page = sysconf(_SC_PAGESIZE);
+	if ((want & PROC_WANT_TOP) && read_file_at(fd, "uptime", data, sizeof(data)) > 0)
+		uptime = strtod(data, NULL);
+
+	while (!stopped && (n = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0) {
+		long off;
+
+		for (off = 0; off < n; ) {
+			struct linux_dirent64 *d = (struct linux_dirent64 *)(buf + off);
+
+			off += d->d_reclen;
+			if (d->d_name[0] < '1' || d->d_name[0] > '9')
+				continue;
+			count++;
+			if (want & PROC_WANT_TOP) {
+				char comm[16];
+				unsigned long flags = 0;
+				unsigned long long ticks, start = 0, rss = 0;
+
+				snprintf(path, sizeof(path), "%s/stat", d->d_name);
+				if (read_file_at(fd, path, data, sizeof(data)) <= 0 ||
+				    parse_stat(data, comm, sizeof(comm), &flags, &ticks, &start, &rss) != 0)
+					continue;
+				if (!wm_name)
+					wm_name = wm_match(comm);
+				if (flags & PF_KTHREAD)
+					continue;
+				top_push(top_mem, &top_mem_n, comm, (double)rss * (double)page);
+				if (clk > 0 && uptime - (double)start / clk >= 1.0)
+					top_push(top_cpu, &top_cpu_n, comm,
+						 100.0 * ((double)ticks / clk) / (uptime - (double)start / clk));
+			} else if (!wm_name) {
+				snprintf(path, sizeof(path), "%s/comm", d->d_name);
+				if (read_file_at(fd, path, data, sizeof(data)) > 0)
+					wm_name = wm_match(data);
+				if (wm_name && want == PROC_WANT_WM) {
+					stopped = 1;
+					break;
+				}
+			}
+		}
+	}
+	close(fd);
+	done |= PROC_WANT_WM;
+	if (!stopped) {
+		/* A WM-only scan that found nothing still walked every PID. */
+		process_count = count;
+		done |= PROC_WANT_COUNT | (want & PROC_WANT_TOP);
+	}
+	debug_log("proc: scanned %ld pids%s, wm %s", count, stopped ? " (stopped early)" : "",
+		  wm_name ? wm_name : "none");
+}
+
+const char *proc_wm_name(void)
+{
+	proc_scan(PROC_WANT_WM);
+	return wm_name;
+}
+
+char *get_processes_str(void)
+{
+	char buf[32];
+
+	proc_scan(PROC_WANT_COUNT);
+	if (process_count <= 0)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%ld", process_count);
+	return xstrdup(buf);
+}
+
+char *get_threads_str(void)
+{
+	char buf[128];
+	char *slash;
+
+	/* The fourth field is "running/total" scheduling entities, i.e. threads. */
+	if (read_file_at(AT_FDCWD, "/proc/loadavg", buf, sizeof(buf)) <= 0)
+		return xstrdup("unknown");
+	slash = strchr(buf, '/');
+	if (!slash)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%ld", strtol(slash + 1, NULL, 10));
+	return xstrdup(buf);
+}
+
+static int top_cmp_desc(const void *a, const void *b)
+{
+	double x = ((const struct proc_top *)a)->val;
+	double y = ((const struct proc_top *)b)->val;
+
+	return (x < y) - (x > y);
+}
+
+static void format_bytes(char *buf, size_t sz, double bytes)
+{
+	if (bytes >= 1024.0 * 1024 * 1024)
+		snprintf(buf, sz, "%.1fG", bytes / (1024.0 * 1024 * 1024));
+	else if (bytes >= 1024.0 * 1024)
+		snprintf(buf, sz, "%.0fM", bytes / (1024.0 * 1024));
+	else
+		snprintf(buf, sz, "%.0fK", bytes / 1024.0);
+}
+
+static char *top_str(struct proc_top *heap, size_t n, int mem)
+{
+	struct proc_top sorted[PROC_TOP_K];
+	char buf[256];
+	size_t i, len = 0;
+
+	if (n == 0)
+		return xstrdup("unknown");
+	memcpy(sorted, heap, n * sizeof(*heap));
+	qsort(sorted, n, sizeof(*sorted), top_cmp_desc);
+	buf[0] = '\0';
+	for (i = 0; i < n && len < sizeof(buf); i++) {
+		char val[32];
+
+		if (mem)
+			format_bytes(val, sizeof(val), sorted[i].val);
+		else
+			snprintf(val, sizeof(val), "%.1f%%", sorted[i].val);
+		len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s%s %s",
+					len ? ", " : "", sorted[i].comm, val);
+	}
+	return xstrdup(buf);
+}
+
+char *get_top_mem_str(void)
+{
+	proc_scan(PROC_WANT_TOP);
+	return top_str(top_mem, top_mem_n, 1);
+}
+
+char *get_top_cpu_str(void)
+{
+	proc_scan(PROC_WANT_TOP);
+	return top_str(top_cpu, top_cpu_n, 0);
+}
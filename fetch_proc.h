@@ -0,0 +1,52 @@
+#ifndef FETCH_PROC_H
+#define FETCH_PROC_H
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  fetch_proc.h
+ *
+ *    Description:  Single-pass /proc scanner built on getdents64. Detects the
+ *                  running window manager or compositor, counts processes and
+ *                  keeps the top memory and CPU consumers. Each PID costs at
+ *                  most one small read.
+ *
+ * =====================================================================================
+ */
+
+/* Number of entries shown by %top_mem% and %top_cpu%. */
+#define PROC_TOP_K	3
+
+/**
+ * @brief Finds a running window manager or compositor by process name. The
+ *        scan stops at the first match when nothing else is needed.
+ * @return A static display name (e.g., "KWin", "Hyprland"), or NULL if none runs.
+ */
+const char *proc_wm_name(void);
+
+/**
+ * @brief Number of processes (e.g., "312").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_processes_str(void);
+
+/**
+ * @brief Number of threads, taken from /proc/loadavg (e.g., "1534").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_threads_str(void);
+
+/**
+ * @brief Largest resident sets (e.g., "firefox 1.2G, Xorg 310M, code 250M").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_top_mem_str(void);
+
+/**
+ * @brief Highest CPU share averaged over each process's lifetime
+ *        (e.g., "firefox 12.3%, Xorg 4.1%, code 2.0%").
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_top_cpu_str(void);
+
+#endif // FETCH_PROC_H
@@ -3,30 +3,173 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
-#include <glob.h>
+#include <strings.h>
+#include <ctype.h>
 
 #include <unistd.h>
 #include <pwd.h>
 #include <sys/utsname.h>
 #include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/wait.h>
 
 #include "fetch_hw.h" 
+#include "fetch_sw.h"
 #include "utils.h"
+#include "sampler.h"
+#include "fetch_net.h"
+#include "fetch_proc.h"
+#include "fetch_pkg.h"
+
+
+#define SHELL_EXEC_TIMEOUT_MS		500
+
+struct shell_family {
+	const char *name;
+	const char *env;
+	const char *flag;
+};
+
+static const struct shell_family shell_families[] = {
+	{ "bash",	"BASH_VERSION",	"--version" },
+	{ "zsh",	"ZSH_VERSION",	"--version" },
+	{ "fish",	"FISH_VERSION",	"--version" },
+	{ "ksh",	"KSH_VERSION",	"--version" },
+	{ "mksh",	"KSH_VERSION",	NULL },
+	{ "tcsh",	NULL,		"--version" },
+	{ "nu",		"NU_VERSION",	"--version" },
+	{ "elvish",	NULL,		"-version" },
+	{ "xonsh",	NULL,		"--version" },
+	{ "dash",	NULL,		NULL },
+	{ "sh",		NULL,		NULL },
+	{ NULL,		NULL,		NULL }
+};
+
+static const struct shell_family *shell_family_lookup(const char *name)
+{
+	int i;
+
+	for (i = 0; shell_families[i].name; i++)
+		if (!strcmp(shell_families[i].name, name))
+			return &shell_families[i];
+	return NULL;
+}
+
+/*
+ * Picks the version out of the first line of "<shell> --version" output:
+ * the first word that starts with a digit ("GNU bash, version 5.2.15(1)-release"
+ * gives "5.2.15(1)-release").
+ */
+static int shell_version_from_output(char *line, char *out, size_t outsz)
+{
+	char *tok;
+	char *save = NULL;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	for (tok = strtok_r(line, " \t,", &save); tok; tok = strtok_r(NULL, " \t,", &save)) {
+		if (*tok >= '0' && *tok <= '9') {
+			snprintf(out, outsz, "%s", tok);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Runs "<path> <flag>" once, without going through /bin/sh, and reads the
+ * first line of its stdout. The child is killed if it does not answer within
+ * SHELL_EXEC_TIMEOUT_MS.
+ */
+static int shell_exec_version(const char *path, const char *flag, char *out, size_t outsz)
+{
+	int fds[2];
+	pid_t pid;
+	char buf[512];
+	size_t len = 0;
+	struct timespec t0, t1;
+	int rc = -1;
+
+	if (pipe(fds) != 0)
+		return -1;
+	pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		int devnull = open("/dev/null", O_RDWR);
+
+		if (devnull >= 0) {
+			dup2(devnull, STDIN_FILENO);
+			dup2(devnull, STDERR_FILENO);
+		}
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execl(path, path, flag, (char *)NULL);
+		_exit(127);
+	}
+	close(fds[1]);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (len < sizeof(buf) - 1) {
+		struct pollfd pfd = { .fd = fds[0], .events = POLLIN };
+		long elapsed;
+		ssize_t n;
+
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		elapsed = (t1.tv_sec - t0.tv_sec) * 1000 + (t1.tv_nsec - t0.tv_nsec) / 1000000;
+		if (elapsed >= SHELL_EXEC_TIMEOUT_MS)
+			break;
+		if (poll(&pfd, 1, (int)(SHELL_EXEC_TIMEOUT_MS - elapsed)) <= 0)
+			break;
+		n = read(fds[0], buf + len, sizeof(buf) - 1 - len);
+		if (n <= 0)
+			break;
+		len += (size_t)n;
+		if (memchr(buf, '\n', len))
+			break;
+	}
+	close(fds[0]);
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+
+	buf[len] = '\0';
+	if (len > 0)
+		rc = shell_version_from_output(buf, out, outsz);
+	return rc;
+}
 
+static char *shell_info_join(const char *name, const char *ver)
+{
+	char *res;
+
+	if (!ver || !*ver)
+		return strdup(name);
+	res = malloc(strlen(name) + 1 + strlen(ver) + 1);
+	if (!res)
+		return strdup(name);
+	sprintf(res, "%s %s", name, ver);
+	return res;
+}
 
 char *get_shell_info(void)
 {
 	char			*env;
 	char			shell_path[256];
 	char			shell_name[128];
-	char			cmd[512];
-	FILE			*pipe;
-	char			line[512];
-	char			*res;
-	const char		*args[] = { "--version", "-version", "-v", "-V", NULL };
-	int			i;
+	char			ver[128];
+	char			key[384];
+	char			cached[640];
+	const struct shell_family *fam;
+	struct stat		st;
 	char			*slash;
 
 	env = getenv("SHELL");
@@ -42,77 +185,196 @@ char *get_shell_info(void)
 	}
 
 	slash = strrchr(shell_path, '/');
-	if (slash)
-		snprintf(shell_name, sizeof(shell_name), "%s", slash + 1);
-	else
-		snprintf(shell_name, sizeof(shell_name), "%s", shell_path);
+	snprintf(shell_name, sizeof(shell_name), "%.127s", slash ? slash + 1 : shell_path);
+	fam = shell_family_lookup(shell_name);
 
-	for (i = 0; args[i]; i++) {
-		snprintf(cmd, sizeof(cmd), "%s %s 2>/dev/null", shell_path, args[i]);
-		pipe = popen(cmd, "r");
-		if (!pipe)
-			continue;
-		if (fgets(line, sizeof(line), pipe) != NULL) {
-			char		*p = line;
-
-			line[strcspn(line, "\r\n")] = 0;
-			while (*p == ' ' || *p == '\t')
-				p++;
-			if (!strncmp(p, shell_name, strlen(shell_name))) {
-				res = strdup(p);
-			} else {
-				res = malloc(strlen(shell_name) + 1 + strlen(p) + 1);
-				if (res)
-					sprintf(res, "%s %s", shell_name, p);
-			}
-			pclose(pipe);
-			return res ? res : strdup(shell_name);
+	if (fam && fam->env) {
+		const char	*e = getenv(fam->env);
+
+		if (e && *e)
+			return shell_info_join(shell_name, e);
+	}
+
+	if (stat(shell_path, &st) != 0)
+		return strdup(shell_name);
+
+	snprintf(key, sizeof(key), "%lu %lu %lld.%09ld %s",
+		 (unsigned long)st.st_dev, (unsigned long)st.st_ino,
+		 (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec, shell_path);
+	if (cache_read("shell", cached, sizeof(cached)) == 0) {
+		char	*tab = strchr(cached, '\t');
+
+		if (tab) {
+			*tab = '\0';
+			tab[1 + strcspn(tab + 1, "\n")] = '\0';
+			/* An empty entry left by an older build is retried. */
+			if (!strcmp(cached, key) && tab[1])
+				return shell_info_join(shell_name, tab + 1);
 		}
-		pclose(pipe);
 	}
 
-	{
-		const char	*ver = NULL;
-
-		if (!strcmp(shell_name, "bash"))
-			ver = getenv("BASH_VERSION");
-		else if (!strcmp(shell_name, "zsh"))
-			ver = getenv("ZSH_VERSION");
-		else if (!strcmp(shell_name, "fish"))
-			ver = getenv("FISH_VERSION");
-		else if (!strcmp(shell_name, "ksh"))
-			ver = getenv("KSH_VERSION");
-
-		if (ver && *ver) {
-			res = malloc(strlen(shell_name) + 1 + strlen(ver) + 1);
-			if (res) {
-				sprintf(res, "%s %s", shell_name, ver);
-				return res;
+	if (fam && !fam->flag)
+		return strdup(shell_name);
+	if (shell_exec_version(shell_path, fam ? fam->flag : "--version", ver, sizeof(ver)) != 0)
+		ver[0] = '\0';
+
+	/* A failed or timed-out probe (e.g. a cold start) is not remembered. */
+	if (ver[0]) {
+		snprintf(cached, sizeof(cached), "%s\t%s\n", key, ver);
+		cache_write("shell", cached);
+	}
+	return shell_info_join(shell_name, ver);
+}
+
+/*
+ * comm of the first ancestor that identifies where cfetch is displayed.
+ * Multiplexer servers and sshd end the walk too: the emulator behind them
+ * is not an ancestor.
+ */
+static const struct {
+	const char *comm;
+	const char *name;
+} terminals[] = {
+	{ "kitty",		"kitty" },
+	{ "alacritty",		"Alacritty" },
+	{ "foot",		"foot" },
+	{ "footclient",		"foot" },
+	{ "wezterm-gui",	"WezTerm" },
+	{ "ghostty",		"Ghostty" },
+	{ "gnome-terminal-",	"GNOME Terminal" },
+	{ "kgx",		"GNOME Console" },
+	{ "konsole",		"Konsole" },
+	{ "xfce4-terminal",	"Xfce Terminal" },
+	{ "mate-terminal",	"MATE Terminal" },
+	{ "lxterminal",		"LXTerminal" },
+	{ "qterminal",		"QTerminal" },
+	{ "terminator",		"Terminator" },
+	{ "tilix",		"Tilix" },
+	{ "terminology",	"Terminology" },
+	{ "sakura",		"Sakura" },
+	{ "xterm",		"xterm" },
+	{ "urxvt",		"urxvt" },
+	{ "urxvtd",		"urxvt" },
+	{ "st",			"st" },
+	{ "tmux: server",	"tmux" },
+	{ "tmux",		"tmux" },
+	{ "screen",		"screen" },
+	{ "SCREEN",		"screen" },
+	{ "zellij",		"zellij" },
+	{ "sshd",		"sshd" },
+	{ "sshd-session",	"sshd" },
+	{ "login",		"tty" },
+	{ NULL,			NULL }
+};
+
+#define TERMINAL_MAX_DEPTH		32
+
+/* One read of /proc/<pid>/stat gives comm, the parent and the start time. */
+static int proc_stat_read(pid_t pid, char *comm, size_t csz, pid_t *ppid,
+			  unsigned long long *start)
+{
+	char path[32];
+	char buf[512];
+	char *lp, *rp;
+	unsigned long long st;
+	int pp;
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+	if (read_file_at(AT_FDCWD, path, buf, sizeof(buf)) <= 0)
+		return -1;
+	lp = strchr(buf, '(');
+	rp = strrchr(buf, ')');
+	if (!lp || !rp || rp < lp)
+		return -1;
+	if (sscanf(rp + 1, " %*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u"
+		   " %*d %*d %*d %*d %*d %*d %llu", &pp, &st) != 2)
+		return -1;
+	if (comm)
+		snprintf(comm, csz, "%.*s", (int)(rp - lp - 1), lp + 1);
+	if (ppid)
+		*ppid = (pid_t)pp;
+	if (start)
+		*start = st;
+	return 0;
+}
+
+static const char *terminal_walk(void)
+{
+	pid_t pid = getppid();
+	int depth, i;
+
+	for (depth = 0; depth < TERMINAL_MAX_DEPTH && pid > 1; depth++) {
+		char comm[32];
+		pid_t ppid;
+
+		if (proc_stat_read(pid, comm, sizeof(comm), &ppid, NULL) != 0)
+			break;
+		for (i = 0; terminals[i].comm; i++)
+			if (!strcmp(comm, terminals[i].comm))
+				return terminals[i].name;
+		pid = ppid;
+	}
+	return NULL;
+}
+
+/*
+ * Every process of a login session shares its terminal, so the answer is
+ * cached under boot id, session id and the session leader's start time.
+ */
+char *get_terminal_str(void)
+{
+	char key[128];
+	char cached[256];
+	char id[64];
+	const char *name;
+	unsigned long long start;
+	pid_t sid = getsid(0);
+	int have_key = 0;
+
+	if (sid > 0 && read_file_at(AT_FDCWD, "/proc/sys/kernel/random/boot_id", id, sizeof(id)) > 0 &&
+	    proc_stat_read(sid, NULL, 0, NULL, &start) == 0) {
+		snprintf(key, sizeof(key), "%s %d %llu", id, (int)sid, start);
+		have_key = 1;
+		if (cache_read("terminal", cached, sizeof(cached)) == 0) {
+			char	*tab = strchr(cached, '\t');
+
+			if (tab) {
+				*tab = '\0';
+				if (!strcmp(cached, key)) {
+					tab[1 + strcspn(tab + 1, "\n")] = '\0';
+					return strdup(tab + 1);
+				}
 			}
 		}
 	}
 
-	return strdup(shell_name);
+	name = terminal_walk();
+	if (!name)
+		name = getenv("TERM_PROGRAM");
+	if (!name || !*name)
+		return strdup("unknown");
+	if (have_key) {
+		snprintf(cached, sizeof(cached), "%s\t%.100s\n", key, name);
+		cache_write("terminal", cached);
+	}
+	return strdup(name);
 }
 
 
 
-char *get_packages_count(const char *distro)
+static char *packages_count_family(enum pkg_family fam)
 {
 	FILE *pipe;
 	char buf[256];
 	long count = 0;
-	char *cmd = NULL;
+	const char *cmd;
 	char *res;
 
-	if (!distro)
-		return xstrdup("unknown");
-
-	if (!strcmp(distro, "arch") || !strcmp(distro, "archlinux"))
+	if (fam == PKG_PACMAN)
 		cmd = "pacman -Qq";
-	else if (!strcmp(distro, "debian") || !strcmp(distro, "ubuntu"))
+	else if (fam == PKG_DPKG)
 		cmd = "dpkg --get-selections";
-	else if (!strcmp(distro, "fedora") || !strcmp(distro, "rhel") || !strcmp(distro, "redhat"))
+	else if (fam == PKG_RPM)
 		cmd = "rpm -qa";
 	else
 		return xstrdup("unknown");
@@ -131,10 +393,23 @@ char *get_packages_count(const char *distro)
 	return res;
 }
 
+char *get_packages_count(const char *distro)
+{
+	return packages_count_family(pkg_family_of(distro));
+}
 
-char *get_wm(void)
+
+/*
+ * The running process list wins over the session variables, which are stale
+ * or missing over SSH and under bare window managers.
+ */
+static const char *get_wm(void)
 {
-	char *env;
+	const char *env;
+
+	env = proc_wm_name();
+	if (env)
+		return env;
 
 	env = getenv("XDG_CURRENT_DESKTOP");
 	if (env && *env)
@@ -171,67 +446,100 @@ char *get_wm_clean(void)
 	return wm;
 }
 
-char *get_distro(void)
+/*
+ * os-release(5): /etc/os-release, or /usr/lib/os-release when /etc has none.
+ * Parsed once per run; every caller shares the same struct.
+ */
+static const struct {
+	const char *key;
+	size_t off;
+	size_t size;
+} os_release_keys[] = {
+	{ "ID",		 offsetof(struct os_release, id),	   sizeof(((struct os_release *)0)->id) },
+	{ "ID_LIKE",	 offsetof(struct os_release, id_like),	   sizeof(((struct os_release *)0)->id_like) },
+	{ "NAME",	 offsetof(struct os_release, name),	   sizeof(((struct os_release *)0)->name) },
+	{ "PRETTY_NAME", offsetof(struct os_release, pretty_name), sizeof(((struct os_release *)0)->pretty_name) },
+	{ "VERSION_ID",	 offsetof(struct os_release, version_id),  sizeof(((struct os_release *)0)->version_id) },
+};
+
+/* Copies a shell-style value: unquoted, "double" (with \ escapes) or 'single'. */
+static void os_release_value(const char *src, char *dst, size_t size)
 {
-	FILE *f = NULL;
-	glob_t gl;
-	char *line = NULL;
-	size_t len = 0;
-	ssize_t nread;
-	char *result = NULL;
+	char quote = 0;
+	size_t n = 0;
 
-	if (glob("/etc/*-release", 0, NULL, &gl) != 0)
+	if (*src == '"' || *src == '\'')
+		quote = *src++;
+	for (; *src && n + 1 < size; src++) {
+		if (quote && *src == quote)
+			break;
+		if (!quote && (*src == ' ' || *src == '\t'))
+			break;
+		if (quote == '"' && *src == '\\' && src[1])
+			src++;
+		dst[n++] = *src;
+	}
+	dst[n] = '\0';
+}
+
+const struct os_release *get_os_release(void)
+{
+	static struct os_release os;
+	static int parsed, found;
+	char buf[4096];
+	char *line, *save = NULL;
+	size_t i;
+
+	if (parsed)
+		return found ? &os : NULL;
+	parsed = 1;
+	if (read_file_at(AT_FDCWD, "/etc/os-release", buf, sizeof(buf)) <= 0 &&
+	    read_file_at(AT_FDCWD, "/usr/lib/os-release", buf, sizeof(buf)) <= 0)
 		return NULL;
 
-	for (size_t i = 0; i < gl.gl_pathc && result == NULL; ++i) {
-		f = fopen(gl.gl_pathv[i], "r");
-		if (!f)
-			continue;
+	for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		char *eq;
 
-		while ((nread = getline(&line, &len, f)) != -1) {
-			char *s = line;
-			while (*s == ' ' || *s == '\t')
-				++s;
-			if (*s == '\0' || *s == '\n' || *s == '#')
-				continue;
-			if (strncmp(s, "ID=", 3) != 0)
-				continue;
-			char *val = s + 3;
-			char *eol = strchr(val, '\n');
-			if (eol) *eol = '\0';
-			while (*val == ' ' || *val == '\t')
-				++val;
-			if (*val == '"' || *val == '\'') {
-				char quote = *val++;
-				char *endq = strrchr(val, quote);
-				if (endq)
-					*endq = '\0';
-			} else {
-				char *t = val + strlen(val) - 1;
-				while (t >= val && (*t == ' ' || *t == '\t')) {
-					*t = '\0';
-					--t;
-				}
-			}
-			result = strdup(val);
-			if (result == NULL) {
-				free(line);
-				fclose(f);
-				globfree(&gl);
-				return NULL;
+		while (*line == ' ' || *line == '\t')
+			line++;
+		if (*line == '#' || !(eq = strchr(line, '=')))
+			continue;
+		*eq = '\0';
+		for (i = 0; i < sizeof(os_release_keys) / sizeof(os_release_keys[0]); i++) {
+			if (!strcmp(line, os_release_keys[i].key)) {
+				os_release_value(eq + 1, (char *)&os + os_release_keys[i].off,
+						 os_release_keys[i].size);
+				found = 1;
+				break;
 			}
-			break;
 		}
-
-		free(line);
-		line = NULL;
-		len = 0;
-		fclose(f);
-		f = NULL;
 	}
+	return found ? &os : NULL;
+}
 
-	globfree(&gl);
-	return result;
+int os_release_next_like(const char **cursor, char *word, size_t size)
+{
+	const char *p = *cursor;
+	size_t n;
+
+	if (!p)
+		return 0;
+	p += strspn(p, " ");
+	n = strcspn(p, " ");
+	if (n == 0)
+		return 0;
+	snprintf(word, size, "%.*s", (int)n, p);
+	*cursor = p + n;
+	return 1;
+}
+
+char *get_distro(void)
+{
+	const struct os_release *os = get_os_release();
+
+	if (!os || !os->id[0])
+		return NULL;
+	return strdup(os->id);
 }
 
 
@@ -280,23 +588,30 @@ char *get_shell_str(void)
 	return xstrdup("unknown");
 }
 
+/* Seconds since boot, read once per run; -1 if unavailable. */
+static double uptime_seconds(void)
+{
+	static double up = -2;
+	char buf[64];
+
+	if (up == -2) {
+		up = -1;
+		if (read_file_at(AT_FDCWD, "/proc/uptime", buf, sizeof(buf)) > 0)
+			up = strtod(buf, NULL);
+	}
+	return up;
+}
+
 char *get_uptime_str(void)
 {
 #if defined(__linux__)
-	FILE *f;
-	double up;
+	double up = uptime_seconds();
 	unsigned long sec;
 	unsigned long d, h, m;
 	char *res;
 
-	f = fopen("/proc/uptime", "r");
-	if (!f)
-		return xstrdup("unknown");
-	if (fscanf(f, "%lf", &up) != 1) {
-		fclose(f);
+	if (up < 0)
 		return xstrdup("unknown");
-	}
-	fclose(f);
 	sec = (unsigned long)up;
 	d = sec / 86400;
 	sec %= 86400;
@@ -320,21 +635,82 @@ char *get_uptime_str(void)
 
 char *get_os_str(void)
 {
-	char *d = get_distro();
+	const struct os_release *os = get_os_release();
+	char *d;
+
+	if (os && os->name[0])
+		return xstrdup(os->name);
+	if (os && os->pretty_name[0])
+		return xstrdup(os->pretty_name);
+	d = get_distro();
 	if (!d)
 		return xstrdup("unknown");
 	capitalize_first(d);
 	return d;
 }
 
+/* Containers and many VMs have no usable board DMI; name the environment instead. */
 char *get_host_str(void)
 {
-	return get_motherboard();
+	char *mb = get_motherboard();
+	char *kind;
+	char buf[96];
+
+	if (mb)
+		return mb;
+	kind = get_container_str();
+	if (kind && strcmp(kind, "none") != 0) {
+		snprintf(buf, sizeof(buf), "%s container", kind);
+	} else {
+		free(kind);
+		kind = get_virt_str();
+		if (!kind || strcmp(kind, "none") == 0) {
+			free(kind);
+			return xstrdup("unknown");
+		}
+		snprintf(buf, sizeof(buf), "%s virtual machine", kind);
+	}
+	free(kind);
+	return xstrdup(buf);
 }
 
 char *get_cpu_str(void)
 {
-	return get_cpu_name();
+	return get_cpu_topology_str();
+}
+
+static char *long_str(long v)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%ld", v);
+	return xstrdup(buf);
+}
+
+char *get_cpu_count_str(const char *what)
+{
+	const struct cpu_topology *t = get_cpu_topology();
+
+	if (!t)
+		return xstrdup("unknown");
+	if (!strcmp(what, "cores"))
+		return long_str(t->cores);
+	if (!strcmp(what, "threads"))
+		return long_str(t->threads);
+	if (!strcmp(what, "sockets"))
+		return long_str(t->sockets);
+	return xstrdup("unknown");
+}
+
+char *get_numa_str(void)
+{
+	const struct cpu_topology *t = get_cpu_topology();
+	char buf[32];
+
+	if (!t || t->numa_nodes == 0)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%d node%s", t->numa_nodes, t->numa_nodes == 1 ? "" : "s");
+	return xstrdup(buf);
 }
 
 char *get_gpu_str(void)
@@ -356,76 +732,259 @@ char *get_wm_str(void)
 	return w;
 }
 
-char *placeholder_value(const char *name)
+static const char *probes_name(enum probe_id probe);
+
+static char *packages_str(void)
 {
-	char *n;
+	return packages_count_family(pkg_family_detect());
+}
 
-	n = str_tolower_dup(name);
-	if (!n)
-		return xstrdup("");
-	if (strcmp(n, "username") == 0) {
-		free(n);
-		return get_username_str();
-	}
-	if (strcmp(n, "hostname") == 0) {
-		free(n);
-		return get_hostname_str();
-	}
-	if (strcmp(n, "os") == 0) {
-		free(n);
-		return get_os_str();
-	}
-	if (strcmp(n, "host") == 0) {
-		free(n);
-		return get_host_str();
-	}
-	if (strcmp(n, "kernel") == 0) {
-		free(n);
-		return get_kernel_str();
-	}
-	if (strcmp(n, "cpu") == 0) {
-		free(n);
-		return get_cpu_str();
-	}
-	if (strcmp(n, "gpu") == 0) {
-		free(n);
-		return get_gpu_str();
-	}
-	if (strcmp(n, "ram") == 0) {
-		free(n);
+static char *cpu_count_value(const struct placeholder_ref *ref)
+{
+	return get_cpu_count_str(probes_name(ref->probe) + 4);
+}
+
+static char *sampled_value(const struct placeholder_ref *ref)
+{
+	return get_sampled_str(probes_name(ref->probe));
+}
+
+/* %ram%, %ram:gib%, %ram:mib% and %ram:percent% all format one meminfo read. */
+static char *ram_value(const struct placeholder_ref *ref)
+{
+	unsigned long long used_kb, total_kb;
+	char buf[48];
+
+	if (!ref->arg || !strcmp(ref->arg, "gib"))
 		return get_ram_str();
+	if (!strcmp(ref->arg, "percent"))
+		return get_ram_percent();
+	if (get_ram_usage(&used_kb, &total_kb) != 0)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%llu/%llu MiB", used_kb / 1024, total_kb / 1024);
+	return xstrdup(buf);
+}
+
+static char *uptime_value(const struct placeholder_ref *ref)
+{
+	char buf[32];
+	double up;
+
+	if (!ref->arg)
+		return get_uptime_str();
+	up = uptime_seconds();
+	if (up < 0)
+		return xstrdup("unknown");
+	snprintf(buf, sizeof(buf), "%lu", (unsigned long)up);
+	return xstrdup(buf);
+}
+
+/* %disk% is the root filesystem; %disk:/path% any mounted filesystem. */
+static char *disk_value(const struct placeholder_ref *ref)
+{
+	if (!ref->arg)
+		return get_disk_info();
+	return get_disk_usage_str(ref->arg);
+}
+
+enum probe_arg {
+	ARG_NONE,
+	ARG_KEYWORD,	/* one of probe_desc.keywords */
+	ARG_PATH	/* an absolute path */
+};
+
+static const char *const ram_keywords[] = { "gib", "mib", "percent", NULL };
+static const char *const uptime_keywords[] = { "seconds", NULL };
+
+/*
+ * Probe registry. Plain probes take no argument and fill `get`; probes with
+ * variants fill `get_ref` and format the shared fact according to ref->arg.
+ */
+static const struct probe_desc {
+	const char *name;
+	char *(*get)(void);
+	char *(*get_ref)(const struct placeholder_ref *ref);
+	enum probe_arg arg;
+	const char *const *keywords;
+} probes[PROBE_COUNT] = {
+	[PROBE_USERNAME]	= { "username",	   get_username_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_HOSTNAME]	= { "hostname",	   get_hostname_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_OS]		= { "os",	   get_os_str,		NULL,		 ARG_NONE,    NULL },
+	[PROBE_HOST]		= { "host",	   get_host_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_BIOS]		= { "bios",	   get_bios_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_CHASSIS]		= { "chassis",	   get_chassis_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_DIMMS]		= { "dimms",	   get_dimms_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_VIRT]		= { "virt",	   get_virt_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_CONTAINER]	= { "container",   get_container_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_INIT]		= { "init",	   get_init_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_KERNEL]		= { "kernel",	   get_kernel_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_CPU]		= { "cpu",	   get_cpu_str,		NULL,		 ARG_NONE,    NULL },
+	[PROBE_CPU_CORES]	= { "cpu_cores",   NULL,		cpu_count_value, ARG_NONE,    NULL },
+	[PROBE_CPU_THREADS]	= { "cpu_threads", NULL,		cpu_count_value, ARG_NONE,    NULL },
+	[PROBE_CPU_SOCKETS]	= { "cpu_sockets", NULL,		cpu_count_value, ARG_NONE,    NULL },
+	[PROBE_CPU_CACHE]	= { "cpu_cache",   get_cpu_cache,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_CPU_FREQ]	= { "cpu_freq",	   get_cpu_freq_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_GOVERNOR]	= { "governor",	   get_governor_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_CPU_USAGE]	= { "cpu_usage",   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_DISK_IO]		= { "disk_io",	   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_NET_RX]		= { "net_rx",	   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_NET_TX]		= { "net_tx",	   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_PSI_CPU]		= { "psi_cpu",	   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_PSI_MEM]		= { "psi_mem",	   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_PSI_IO]		= { "psi_io",	   NULL,		sampled_value,	 ARG_NONE,    NULL },
+	[PROBE_CPU_TEMP]	= { "cpu_temp",	   get_cpu_temp,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_GPU_TEMP]	= { "gpu_temp",	   get_gpu_temp,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_BATTERY]		= { "battery",	   get_battery_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_POWER]		= { "power",	   get_power_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_IP]		= { "ip",	   get_ip_str,		NULL,		 ARG_NONE,    NULL },
+	[PROBE_IFACES]		= { "ifaces",	   get_ifaces_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_LINK_SPEED]	= { "link_speed",  get_link_speed_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_NUMA]		= { "numa",	   get_numa_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_GPU]		= { "gpu",	   get_gpu_str,		NULL,		 ARG_NONE,    NULL },
+	[PROBE_RAM]		= { "ram",	   NULL,		ram_value,	 ARG_KEYWORD, ram_keywords },
+	[PROBE_RAM_PERCENT]	= { "ram_percent", get_ram_percent,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_SWAP]		= { "swap",	   get_swap_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_ZRAM]		= { "zram",	   get_zram_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_HUGEPAGES]	= { "hugepages",   get_hugepages_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_UPDATES]		= { "updates",	   get_updates_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_SHELL]		= { "shell",	   get_shell_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_UPTIME]		= { "uptime",	   NULL,		uptime_value,	 ARG_KEYWORD, uptime_keywords },
+	[PROBE_WM]		= { "wm",	   get_wm_str,		NULL,		 ARG_NONE,    NULL },
+	[PROBE_PROCESSES]	= { "processes",   get_processes_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_THREADS]		= { "threads",	   get_threads_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_TOP_MEM]		= { "top_mem",	   get_top_mem_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_TOP_CPU]		= { "top_cpu",	   get_top_cpu_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_TERMINAL]	= { "terminal",	   get_terminal_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_SHELL_INFO]	= { "shell_info",  get_shell_info,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_MONITOR]		= { "monitor",	   get_monitor_info,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_DISK]		= { "disk",	   NULL,		disk_value,	 ARG_PATH,    NULL },
+	[PROBE_STORAGE]		= { "storage",	   get_storage_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_DISKS]		= { "disks",	   get_disks_str,	NULL,		 ARG_NONE,    NULL },
+	[PROBE_PACKAGES]	= { "packages",	   packages_str,	NULL,		 ARG_NONE,    NULL },
+};
+
+static const char *probes_name(enum probe_id probe)
+{
+	return probe > PROBE_NONE && probe < PROBE_COUNT ? probes[probe].name : "";
+}
+
+static int probe_arg_valid(const struct probe_desc *d, const char *arg)
+{
+	int i;
+
+	if (!arg)
+		return 1;
+	if (d->arg == ARG_PATH)
+		return arg[0] == '/';
+	if (d->arg == ARG_KEYWORD)
+		for (i = 0; d->keywords[i]; i++)
+			if (!strcmp(arg, d->keywords[i]))
+				return 1;
+	return 0;
+}
+
+int placeholder_parse(const char *text, size_t len, struct placeholder_ref *ref)
+{
+	const char *colon = memchr(text, ':', len);
+	size_t nlen = colon ? (size_t)(colon - text) : len;
+	int p;
+
+	ref->probe = PROBE_NONE;
+	ref->arg = NULL;
+	for (p = PROBE_NONE + 1; p < PROBE_COUNT; p++) {
+		if (strlen(probes[p].name) == nlen && !strncasecmp(text, probes[p].name, nlen))
+			break;
 	}
-	if (strcmp(n, "shell") == 0) {
-		free(n);
-		return get_shell_str();
+	if (p == PROBE_COUNT)
+		return -1;
+	if (colon && colon + 1 < text + len) {
+		ref->arg = strndup(colon + 1, len - nlen - 1);
+		if (!ref->arg)
+			return -1;
+		/* Keywords are lower-cased so the memo keys are canonical; paths are kept as is. */
+		if (probes[p].arg == ARG_KEYWORD) {
+			char *c;
+
+			for (c = ref->arg; *c; c++)
+				*c = (char)tolower((unsigned char)*c);
+		}
 	}
-	if (strcmp(n, "uptime") == 0) {
-		free(n);
-		return get_uptime_str();
+	if (!probe_arg_valid(&probes[p], ref->arg)) {
+		free(ref->arg);
+		ref->arg = NULL;
+		return -1;
 	}
-	if (strcmp(n, "wm") == 0) {
-		free(n);
-		return get_wm_str();
+	ref->probe = (enum probe_id)p;
+	return 0;
+}
+
+int placeholder_ref_sampled(const struct placeholder_ref *ref)
+{
+	return ref->probe != PROBE_NONE && placeholder_is_sampled(probes_name(ref->probe));
+}
+
+static char *placeholder_compute(const struct placeholder_ref *ref)
+{
+	const struct probe_desc *d;
+
+	if (ref->probe <= PROBE_NONE || ref->probe >= PROBE_COUNT)
+		return xstrdup("");
+	d = &probes[ref->probe];
+	return d->get ? d->get() : d->get_ref(ref);
+}
+
+/*
+ * Every probe runs at most once per run: values are kept by probe and
+ * argument so frame modes, which measure a line before printing it, and the
+ * prefetch pass done inside the sampling window all share one result.
+ */
+struct value_memo {
+	enum probe_id probe;
+	char *arg;
+	char *val;
+};
+
+static struct value_memo *memo;
+static size_t memo_count;
+
+static int arg_equal(const char *a, const char *b)
+{
+	return (!a && !b) || (a && b && !strcmp(a, b));
+}
+
+const char *placeholder_value_cached(const struct placeholder_ref *ref)
+{
+	char *val;
+	size_t i;
+	struct value_memo *tmp;
+
+	for (i = 0; i < memo_count; i++)
+		if (memo[i].probe == ref->probe && arg_equal(memo[i].arg, ref->arg))
+			return memo[i].val;
+	val = placeholder_compute(ref);
+	if (!val)
+		return "";
+	tmp = realloc(memo, sizeof(*memo) * (memo_count + 1));
+	if (!tmp) {
+		free(val);
+		return "";
 	}
-	if (strcmp(n, "shell_info") == 0) {
-		free(n);
-		return get_shell_info();
+	memo = tmp;
+	memo[memo_count].probe = ref->probe;
+	memo[memo_count].arg = ref->arg ? xstrdup(ref->arg) : NULL;
+	memo[memo_count].val = val;
+	return memo[memo_count++].val;
+}
+
+void placeholder_cache_free(void)
+{
+	size_t i;
+
+	for (i = 0; i < memo_count; i++) {
+		free(memo[i].arg);
+		free(memo[i].val);
 	}
-	if (strcmp(n, "monitor") == 0) {
-		free(n);
-		return get_monitor_info();
-        }	
-	if (strcmp(n, "disk") == 0) {
-		free(n);
-		return get_disk_info();
-        }
-        if (strcmp(n, "packages") == 0) {
-		free(n);
-		char *d = get_distro();
-		char *val = get_packages_count(d);
-		if (d) free(d);
-		return val;
-        }
-	free(n);
-	return xstrdup("");
+	free(memo);
+	memo = NULL;
+	memo_count = 0;
 }
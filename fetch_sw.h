@@ -11,6 +11,8 @@
  * =====================================================================================
  */
 
+#include <stddef.h>
+
 
 /**
  * @brief Fetches the name and version of the current user's shell.
@@ -20,6 +22,14 @@
  */
 char *get_shell_info(void);
 
+/**
+ * @brief Detects the terminal emulator, multiplexer or SSH session cfetch runs in
+ *        by walking the parent processes (e.g., "kitty", "tmux", "sshd").
+ *        The result is cached per login session.
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_terminal_str(void);
+
 
 /**
  * @brief Fetches the total number of installed packages based on the distribution.
@@ -39,6 +49,33 @@ char *get_packages_count(const char *distro);
 char *get_wm_clean(void);
 
 
+/* Fields of os-release(5) used by cfetch. Missing keys are empty strings. */
+struct os_release {
+	char id[64];
+	char id_like[128];
+	char name[128];
+	char pretty_name[128];
+	char version_id[64];
+};
+
+/**
+ * @brief Parses /etc/os-release (or /usr/lib/os-release) once per run.
+ * @return A pointer to static storage, or NULL if neither file is readable.
+ */
+const struct os_release *get_os_release(void);
+
+/**
+ * @brief Iterates the space-separated ID_LIKE list.
+ * @param cursor Points into the list; advanced past each returned word.
+ * @param word Receives the next entry (e.g., "rhel").
+ * @return 1 if a word was stored, 0 at the end of the list.
+ */
+int os_release_next_like(const char **cursor, char *word, size_t size);
+
+/**
+ * @brief The os-release ID (e.g., "arch", "debian").
+ * @return A dynamically allocated string, or NULL if unknown. The caller must free it.
+ */
 char *get_distro(void);
 
 char *get_username_str(void);
@@ -57,13 +94,107 @@ char *get_host_str(void);
 
 char *get_cpu_str(void);
 
+char *get_cpu_count_str(const char *what);
+
+char *get_numa_str(void);
+
 char *get_gpu_str(void);
 
 char *get_ram_str(void);
 
 char *get_wm_str(void);
 
-char *placeholder_value(const char *name);
+/* One entry per probe; placeholders with arguments share their probe's ID. */
+enum probe_id {
+	PROBE_NONE,
+	PROBE_USERNAME,
+	PROBE_HOSTNAME,
+	PROBE_OS,
+	PROBE_HOST,
+	PROBE_BIOS,
+	PROBE_CHASSIS,
+	PROBE_DIMMS,
+	PROBE_VIRT,
+	PROBE_CONTAINER,
+	PROBE_INIT,
+	PROBE_KERNEL,
+	PROBE_CPU,
+	PROBE_CPU_CORES,
+	PROBE_CPU_THREADS,
+	PROBE_CPU_SOCKETS,
+	PROBE_CPU_CACHE,
+	PROBE_CPU_FREQ,
+	PROBE_GOVERNOR,
+	PROBE_CPU_USAGE,
+	PROBE_DISK_IO,
+	PROBE_NET_RX,
+	PROBE_NET_TX,
+	PROBE_PSI_CPU,
+	PROBE_PSI_MEM,
+	PROBE_PSI_IO,
+	PROBE_CPU_TEMP,
+	PROBE_GPU_TEMP,
+	PROBE_BATTERY,
+	PROBE_POWER,
+	PROBE_IP,
+	PROBE_IFACES,
+	PROBE_LINK_SPEED,
+	PROBE_NUMA,
+	PROBE_GPU,
+	PROBE_RAM,
+	PROBE_RAM_PERCENT,
+	PROBE_SWAP,
+	PROBE_ZRAM,
+	PROBE_HUGEPAGES,
+	PROBE_UPDATES,
+	PROBE_SHELL,
+	PROBE_UPTIME,
+	PROBE_WM,
+	PROBE_PROCESSES,
+	PROBE_THREADS,
+	PROBE_TOP_MEM,
+	PROBE_TOP_CPU,
+	PROBE_TERMINAL,
+	PROBE_SHELL_INFO,
+	PROBE_MONITOR,
+	PROBE_DISK,
+	PROBE_STORAGE,
+	PROBE_DISKS,
+	PROBE_PACKAGES,
+	PROBE_COUNT
+};
+
+/* A parsed %name% or %name:arg% placeholder. */
+struct placeholder_ref {
+	enum probe_id probe;
+	char *arg;		/* text after the first ':', or NULL */
+};
+
+/**
+ * @brief Parses placeholder text (without the percent signs), e.g. "disk:/home"
+ *        or "RAM:percent". The name and keyword arguments are case-insensitive
+ *        (keywords are stored lower-case); a path argument is kept as is.
+ * @param ref Receives the probe and a heap copy of the argument (free ref->arg).
+ * @return 0 on success, -1 for an unknown name or an argument the probe rejects.
+ */
+int placeholder_parse(const char *text, size_t len, struct placeholder_ref *ref);
+
+/**
+ * @brief Tells whether a parsed placeholder needs the rate sampler.
+ */
+int placeholder_ref_sampled(const struct placeholder_ref *ref);
+
+/**
+ * @brief Resolves a parsed placeholder. Each probe and argument pair is
+ *        computed once per run; later calls return the same string.
+ * @return A string owned by the cache, valid until placeholder_cache_free().
+ */
+const char *placeholder_value_cached(const struct placeholder_ref *ref);
+
+/**
+ * @brief Releases the values remembered by placeholder_value_cached().
+ */
+void placeholder_cache_free(void);
 
 void capitalize_first(char *s);
 
@@ -15,6 +15,9 @@
 #include "utils.h"
 #include "ascii_gen.h"
 #include "config.h"
+#include "sampler.h"
+#include "fetch_net.h"
+#include "outbuf.h"
 
 #define MAX_ASCII_FILE_LINES            1000
 #define MAX_ASCII_FILE_LINE_LENGTH      512
@@ -27,6 +30,11 @@ int main(int argc, char *argv[])
 
 	cfg_init_defaults(&cfg);
 	cfg_load(&cfg);
+	net_probe_configure(cfg.net_ignore, cfg.net_ignore_kinds);
+	sampler_configure(cfg.sample_window);
+	out_configure(cfg.cursor_forward);
+	if (info_lines_need_sampler(&cfg))
+		sampler_begin();
 
 	distro = get_distro();
 
@@ -92,6 +100,8 @@ int main(int argc, char *argv[])
 
 	if (distro != NULL)
 		free(distro);
+	placeholder_cache_free();
+	net_probe_free();
 	cfg_free(&cfg);
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+/* Files includes. */
+#include "color.h"
+#include "outbuf.h"
+#include "utils.h"
+
+/* A typical framed render is a few KiB; this avoids regrowing in the common case. */
+#define OUT_INITIAL_CAP	8192
+
+static char *buf;
+static size_t len;
+static size_t cap;
+static int failed;
+static size_t saved;
+static int cursor_ok = -1;
+static int cursor_allowed = 1;
+static size_t term_cols;
+
+/* Makes room for n more bytes. On allocation failure the render is dropped at flush. */
+static int out_reserve(size_t n)
+{
+	size_t ncap;
+	char *tmp;
+
+	if (failed)
+		return -1;
+	if (len + n <= cap)
+		return 0;
+	ncap = cap ? cap : OUT_INITIAL_CAP;
+	while (ncap < len + n)
+		ncap *= 2;
+	tmp = realloc(buf, ncap);
+	if (!tmp) {
+		failed = 1;
+		return -1;
+	}
+	buf = tmp;
+	cap = ncap;
+	return 0;
+}
+
+void out_write(const void *data, size_t n)
+{
+	if (n == 0 || out_reserve(n) != 0)
+		return;
+	memcpy(buf + len, data, n);
+	len += n;
+}
+
+void out_puts(const char *s)
+{
+	if (s)
+		out_write(s, strlen(s));
+}
+
+void out_putc(char c)
+{
+	if (out_reserve(1) != 0)
+		return;
+	buf[len++] = c;
+}
+
+void out_printf(const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = vsnprintf(buf ? buf + len : NULL, buf ? cap - len : 0, fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+	if (buf && (size_t)n < cap - len) {
+		len += (size_t)n;
+		return;
+	}
+	if (out_reserve((size_t)n + 1) != 0)
+		return;
+	va_start(ap, fmt);
+	vsnprintf(buf + len, cap - len, fmt, ap);
+	va_end(ap);
+	len += (size_t)n;
+}
+
+void out_repeat(const char *unit, size_t count)
+{
+	size_t ulen = strlen(unit);
+	size_t total = ulen * count;
+	size_t done;
+	char *run;
+
+	if (total == 0 || out_reserve(total) != 0)
+		return;
+	run = buf + len;
+	memcpy(run, unit, ulen);
+	/* Each pass copies everything written so far: log2(count) memcpy calls. */
+	for (done = ulen; done < total; done *= 2)
+		memcpy(run + done, run, done <= total - done ? done : total - done);
+	len += total;
+}
+
+void out_configure(int cursor_forward)
+{
+	cursor_allowed = cursor_forward;
+	cursor_ok = -1;
+}
+
+/*
+ * Upper bound of the cursor column at the end of the buffer, counted from
+ * the last newline (a render starts at column 0). Escapes take no columns
+ * except CSI n C, and every 3- or 4-byte UTF-8 sequence counts as wide.
+ */
+static size_t out_column(void)
+{
+	size_t start = len, i, col = 0;
+
+	while (start > 0 && buf[start - 1] != '\n')
+		start--;
+	for (i = start; i < len; i++) {
+		unsigned char c = (unsigned char)buf[i];
+
+		if (c == 0x1b && i + 1 < len && buf[i + 1] == '[') {
+			size_t arg = 0;
+
+			for (i += 2; i < len && (unsigned char)buf[i] < 0x40; i++)
+				if (buf[i] >= '0' && buf[i] <= '9')
+					arg = arg * 10 + (size_t)(buf[i] - '0');
+			if (i < len && buf[i] == 'C')
+				col += arg ? arg : 1;
+		} else if (c >= 0xE0) {
+			col += 2;
+		} else if (c < 0x80 || c >= 0xC0) {
+			col++;
+		}
+	}
+	return col;
+}
+
+void out_blank(size_t n)
+{
+	char seq[24];
+	int k;
+
+	/* Same decision as the colors: no escapes at all at COLOR_DEPTH_NONE. */
+	if (cursor_ok < 0) {
+		struct winsize ws;
+
+		cursor_ok = cursor_allowed && color_depth() != COLOR_DEPTH_NONE &&
+			    ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0;
+		term_cols = cursor_ok ? ws.ws_col : 0;
+	}
+	/* CSI C stops at the margin where spaces would wrap, so the run must end before it. */
+	if (cursor_ok && out_column() + n < term_cols) {
+		k = snprintf(seq, sizeof(seq), "\x1b[%zuC", n);
+		if (k > 0 && (size_t)k < n) {
+			out_write(seq, (size_t)k);
+			saved += n - (size_t)k;
+			return;
+		}
+	}
+	out_repeat(" ", n);
+}
+
+void out_saved(size_t n)
+{
+	saved += n;
+}
+
+int out_flush(void)
+{
+	size_t off = 0;
+	int ret = 0;
+
+	if (failed) {
+		debug_log("out: allocation failed, render dropped");
+		failed = 0;
+		len = 0;
+		return -1;
+	}
+	fflush(stdout);
+	while (off < len) {
+		ssize_t n = write(STDOUT_FILENO, buf + off, len - off);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = -1;
+			break;
+		}
+		off += (size_t)n;
+	}
+	debug_log("out: flushed %zu bytes, %zu saved by the encoder", len, saved);
+	len = 0;
+	saved = 0;
+	return ret;
+}
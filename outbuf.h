@@ -0,0 +1,71 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stddef.h>
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  outbuf.h
+ *
+ *    Description:  Growable output buffer for rendering. Everything a render
+ *                  produces is appended here and handed to the terminal with a
+ *                  single write() by out_flush().
+ *
+ * =====================================================================================
+ */
+
+/**
+ * @brief Appends len bytes of data.
+ */
+void out_write(const void *data, size_t len);
+
+/**
+ * @brief Appends a NUL-terminated string.
+ */
+void out_puts(const char *s);
+
+/**
+ * @brief Appends a single byte.
+ */
+void out_putc(char c);
+
+/**
+ * @brief Appends formatted text, like printf().
+ */
+void out_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Appends count copies of a byte sequence (a space, or a UTF-8 glyph
+ *        such as "─"). The run is built by doubling, not one copy at a time.
+ */
+void out_repeat(const char *unit, size_t count);
+
+/**
+ * @brief Appends n columns of blank space. When escapes are allowed (see
+ *        color_depth()), the terminal width is known and the run ends before
+ *        the right margin, a long run becomes a cursor-forward sequence
+ *        (CSI n C). That assumes the cells skipped over are already blank,
+ *        as they are on freshly scrolled rows; otherwise it is n spaces.
+ */
+void out_blank(size_t n);
+
+/**
+ * @brief Allows or forbids cursor-forward sequences in out_blank().
+ * @param cursor_forward 0 to always write spaces. Allowed by default.
+ */
+void out_configure(int cursor_forward);
+
+/**
+ * @brief Records bytes an encoder avoided writing, for the debug summary.
+ */
+void out_saved(size_t n);
+
+/**
+ * @brief Writes the buffered bytes to stdout and empties the buffer. The
+ *        storage is kept for the next render.
+ * @return 0 on success, -1 on a write error.
+ */
+int out_flush(void);
+
+#endif // OUTBUF_H
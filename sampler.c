@@ -0,0 +1,301 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+
+/* Files includes. */
+#include "sampler.h"
+#include "fetch_hw.h"
+#include "fetch_net.h"
+#include "utils.h"
+
+struct sample {
+	struct timespec ts;
+	unsigned long long cpu_busy;
+	unsigned long long cpu_total;
+	unsigned long long disk_rd_sectors;
+	unsigned long long disk_wr_sectors;
+	unsigned long long net_rx_bytes;
+	unsigned long long net_tx_bytes;
+	struct psi_stat psi[PSI_RESOURCES];
+	unsigned int psi_ok;
+};
+
+enum { SAMPLER_IDLE, SAMPLER_OPEN, SAMPLER_CLOSED };
+
+static int state = SAMPLER_IDLE;
+static struct sample first, second;
+
+/*
+ * "\nname1\nname2\n" list, built once in sampler_begin(), so both samples
+ * filter /proc/diskstats without touching sysfs again. /proc/net/dev is
+ * filtered by the interface rules of fetch_net.
+ */
+static char *whole_disks;
+
+static char *dir_names(const char *path, const char *const skip[])
+{
+	DIR *d;
+	struct dirent *de;
+	size_t cap = 256, len = 1;
+	char *out;
+
+	d = opendir(path);
+	if (!d)
+		return NULL;
+	out = malloc(cap);
+	if (!out) {
+		closedir(d);
+		return NULL;
+	}
+	out[0] = '\n';
+	out[1] = '\0';
+	while ((de = readdir(d)) != NULL) {
+		size_t n = strlen(de->d_name);
+		int i, skipped = 0;
+
+		if (de->d_name[0] == '.')
+			continue;
+		for (i = 0; skip && skip[i]; i++)
+			if (!strncmp(de->d_name, skip[i], strlen(skip[i])))
+				skipped = 1;
+		if (skipped)
+			continue;
+		if (len + n + 2 > cap) {
+			char *tmp;
+
+			cap = (len + n + 2) * 2;
+			tmp = realloc(out, cap);
+			if (!tmp)
+				break;
+			out = tmp;
+		}
+		memcpy(out + len, de->d_name, n);
+		len += n;
+		out[len++] = '\n';
+		out[len] = '\0';
+	}
+	closedir(d);
+	return out;
+}
+
+static int name_listed(const char *list, const char *name, size_t n)
+{
+	const char *p = list;
+
+	if (!list)
+		return 0;
+	while ((p = strstr(p, name)) != NULL) {
+		if (p > list && p[-1] == '\n' && p[n] == '\n')
+			return 1;
+		p++;
+	}
+	return 0;
+}
+
+static void sample_cpu(struct sample *s)
+{
+	char buf[512];
+	unsigned long long v[10] = { 0 };
+
+	if (read_file_at(AT_FDCWD, "/proc/stat", buf, sizeof(buf)) <= 0)
+		return;
+	if (sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+		   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 4)
+		return;
+	s->cpu_total = v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6] + v[7];
+	s->cpu_busy = s->cpu_total - v[3] - v[4];
+}
+
+static void sample_disks(struct sample *s)
+{
+	char *buf = read_file_alloc("/proc/diskstats", NULL);
+	char *line, *save = NULL;
+
+	if (!buf)
+		return;
+	for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		char name[64];
+		unsigned long long rd, wr;
+		unsigned int major, minor;
+
+		if (sscanf(line, "%u %u %63s %*u %*u %llu %*u %*u %*u %llu",
+			   &major, &minor, name, &rd, &wr) != 5)
+			continue;
+		if (!name_listed(whole_disks, name, strlen(name)))
+			continue;
+		s->disk_rd_sectors += rd;
+		s->disk_wr_sectors += wr;
+	}
+	free(buf);
+}
+
+static void sample_net(struct sample *s)
+{
+	char *buf = read_file_alloc("/proc/net/dev", NULL);
+	char *line, *save = NULL;
+
+	if (!buf)
+		return;
+	for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		char *colon = strchr(line, ':');
+		char *name = line;
+		unsigned long long rx, tx;
+
+		if (!colon)
+			continue;
+		*colon = '\0';
+		while (*name == ' ')
+			name++;
+		if (net_iface_ignored(name))
+			continue;
+		if (sscanf(colon + 1, "%llu %*u %*u %*u %*u %*u %*u %*u %llu", &rx, &tx) != 2)
+			continue;
+		s->net_rx_bytes += rx;
+		s->net_tx_bytes += tx;
+	}
+	free(buf);
+}
+
+static void sample_psi(struct sample *s)
+{
+	int r;
+
+	for (r = 0; r < PSI_RESOURCES; r++)
+		if (psi_read((enum psi_resource)r, &s->psi[r]) == 0)
+			s->psi_ok |= 1u << r;
+}
+
+static void take_sample(struct sample *s)
+{
+	memset(s, 0, sizeof(*s));
+	sample_cpu(s);
+	sample_disks(s);
+	sample_net(s);
+	sample_psi(s);
+	clock_gettime(CLOCK_MONOTONIC, &s->ts);
+}
+
+static int min_window_ms;
+
+static double elapsed_secs(const struct timespec *a, const struct timespec *b)
+{
+	return (double)(b->tv_sec - a->tv_sec) + (double)(b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+void sampler_configure(int ms)
+{
+	min_window_ms = ms > 0 ? ms : 0;
+}
+
+void sampler_begin(void)
+{
+	/* Stacked devices (dm, md) and memory-backed ones would count I/O twice. */
+	static const char *const disk_skip[] = { "loop", "ram", "zram", "dm-", "md", NULL };
+
+	if (state != SAMPLER_IDLE)
+		return;
+	whole_disks = dir_names("/sys/block", disk_skip);
+	take_sample(&first);
+	state = SAMPLER_OPEN;
+}
+
+void sampler_end(void)
+{
+	struct timespec now;
+	double rest;
+
+	if (state != SAMPLER_OPEN)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	rest = min_window_ms / 1000.0 - elapsed_secs(&first.ts, &now);
+	if (rest > 0) {
+		struct timespec ts;
+
+		ts.tv_sec = (time_t)rest;
+		ts.tv_nsec = (long)((rest - (double)ts.tv_sec) * 1e9);
+		nanosleep(&ts, NULL);
+	}
+	take_sample(&second);
+	state = SAMPLER_CLOSED;
+	debug_log("sampler: %.2f ms window", elapsed_secs(&first.ts, &second.ts) * 1000.0);
+	free(whole_disks);
+	whole_disks = NULL;
+}
+
+int placeholder_is_sampled(const char *name)
+{
+	return !strcmp(name, "cpu_usage") || !strcmp(name, "disk_io") ||
+	       !strcmp(name, "net_rx") || !strcmp(name, "net_tx") ||
+	       !strcmp(name, "psi_cpu") || !strcmp(name, "psi_mem") || !strcmp(name, "psi_io");
+}
+
+static void format_rate(char *buf, size_t sz, double bytes_per_sec)
+{
+	if (bytes_per_sec >= 1024.0 * 1024 * 1024)
+		snprintf(buf, sz, "%.1f GB/s", bytes_per_sec / (1024.0 * 1024 * 1024));
+	else if (bytes_per_sec >= 1024.0 * 1024)
+		snprintf(buf, sz, "%.1f MB/s", bytes_per_sec / (1024.0 * 1024));
+	else if (bytes_per_sec >= 1024.0)
+		snprintf(buf, sz, "%.1f KB/s", bytes_per_sec / 1024.0);
+	else
+		snprintf(buf, sz, "%.0f B/s", bytes_per_sec);
+}
+
+static int psi_resource_of(const char *name)
+{
+	if (!strcmp(name, "psi_cpu"))
+		return PSI_CPU;
+	if (!strcmp(name, "psi_mem"))
+		return PSI_MEMORY;
+	if (!strcmp(name, "psi_io"))
+		return PSI_IO;
+	return -1;
+}
+
+char *get_sampled_str(const char *name)
+{
+	char buf[96];
+	double secs;
+
+	if (state == SAMPLER_IDLE)
+		sampler_begin();
+	sampler_end();
+	secs = elapsed_secs(&first.ts, &second.ts);
+	if (secs <= 0)
+		return xstrdup("unknown");
+
+	if (!strcmp(name, "cpu_usage")) {
+		unsigned long long total = second.cpu_total - first.cpu_total;
+
+		if (total == 0)
+			return xstrdup("unknown");
+		snprintf(buf, sizeof(buf), "%.1f%%",
+			 100.0 * (double)(second.cpu_busy - first.cpu_busy) / (double)total);
+	} else if (!strcmp(name, "disk_io")) {
+		char rd[32], wr[32];
+
+		format_rate(rd, sizeof(rd), (second.disk_rd_sectors - first.disk_rd_sectors) * 512.0 / secs);
+		format_rate(wr, sizeof(wr), (second.disk_wr_sectors - first.disk_wr_sectors) * 512.0 / secs);
+		snprintf(buf, sizeof(buf), "R %s, W %s", rd, wr);
+	} else if (!strcmp(name, "net_rx")) {
+		format_rate(buf, sizeof(buf), (second.net_rx_bytes - first.net_rx_bytes) / secs);
+	} else if (!strcmp(name, "net_tx")) {
+		format_rate(buf, sizeof(buf), (second.net_tx_bytes - first.net_tx_bytes) / secs);
+	} else if (psi_resource_of(name) >= 0) {
+		int r = psi_resource_of(name);
+		const struct psi_stat *a = &first.psi[r], *b = &second.psi[r];
+
+		if (!(first.psi_ok & second.psi_ok & (1u << r)))
+			return xstrdup("unknown");
+		/* total is in microseconds, so stall share over the window is us / (secs * 1e6). */
+		snprintf(buf, sizeof(buf), "%.1f%% now, %.1f%% avg10, %.1f%% avg60",
+			 (double)(b->total - a->total) / (secs * 10000.0), b->avg10, b->avg60);
+	} else {
+		return xstrdup("unknown");
+	}
+	return xstrdup(buf);
+}
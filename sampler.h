@@ -0,0 +1,51 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sampler.h
+ *
+ *    Description:  Two-sample rate engine for CPU usage, disk I/O, network
+ *                  throughput and pressure-stall time. The first sample is taken at startup, the second
+ *                  right before rendering, so the window overlaps every other probe.
+ *
+ * =====================================================================================
+ */
+
+/**
+ * @brief Sets the shortest window in milliseconds. When the other probes
+ *        finish sooner, sampler_end() sleeps for the rest. 0 (the default)
+ *        never waits.
+ */
+void sampler_configure(int min_window_ms);
+
+/**
+ * @brief Takes the first sample of /proc/stat, /proc/diskstats, /proc/net/dev
+ *        and the cpu/memory/io pressure files.
+ */
+void sampler_begin(void);
+
+/**
+ * @brief Takes the second sample, after the configured minimum window.
+ *        Does nothing if sampler_begin() was not called or the window is
+ *        already closed.
+ */
+void sampler_end(void);
+
+/**
+ * @brief Tells whether a placeholder needs both samples.
+ * @param name Lowercase placeholder name (e.g., "cpu_usage").
+ * @return 1 for sampled placeholders, 0 otherwise.
+ */
+int placeholder_is_sampled(const char *name);
+
+/**
+ * @brief Formats a sampled placeholder. Closes the window if still open.
+ * @param name Lowercase placeholder name: cpu_usage, disk_io, net_rx, net_tx,
+ *        psi_cpu, psi_mem or psi_io.
+ * @return A dynamically allocated string. The caller must free it.
+ */
+char *get_sampled_str(const char *name);
+
+#endif // SAMPLER_H
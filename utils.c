@@ -1,8 +1,17 @@
+#define _POSIX_C_SOURCE 200809L
 #include <ctype.h> 
 #include <stddef.h> 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* Files includes. */
 #include "utils.h"
@@ -137,4 +146,399 @@ size_t strlen_safe(const char *s)
 	if (!s)
 		return 0;
 	return strlen(s);
-}
\ No newline at end of file
+}
+
+char *cache_path(const char *name)
+{
+	const char *xdg;
+	const char *home;
+	char dir[512];
+	size_t n;
+	char *p;
+
+	xdg = getenv("XDG_CACHE_HOME");
+	home = getenv("HOME");
+	if (xdg && *xdg) {
+		mkdir(xdg, 0755);
+		snprintf(dir, sizeof(dir), "%s/cfetch", xdg);
+	} else if (home && *home) {
+		snprintf(dir, sizeof(dir), "%s/.cache", home);
+		mkdir(dir, 0755);
+		snprintf(dir, sizeof(dir), "%s/.cache/cfetch", home);
+	} else {
+		return NULL;
+	}
+	mkdir(dir, 0755);
+
+	n = strlen(dir) + 1 + strlen(name) + 1;
+	p = malloc(n);
+	if (!p)
+		return NULL;
+	snprintf(p, n, "%s/%s", dir, name);
+	return p;
+}
+
+int cache_read(const char *name, char *buf, size_t sz)
+{
+	char *path;
+	int fd;
+	ssize_t n;
+
+	if (sz == 0)
+		return -1;
+	path = cache_path(name);
+	if (!path)
+		return -1;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	free(path);
+	if (fd < 0)
+		return -1;
+	n = read(fd, buf, sz - 1);
+	close(fd);
+	if (n <= 0)
+		return -1;
+	buf[n] = '\0';
+	return 0;
+}
+
+int cache_write(const char *name, const char *data)
+{
+	char *path;
+	char tmp[600];
+	size_t len = strlen(data);
+	int fd;
+	int rc = -1;
+
+	path = cache_path(name);
+	if (!path)
+		return -1;
+	snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd >= 0) {
+		int ok = write(fd, data, len) == (ssize_t)len;
+
+		if (close(fd) == 0 && ok)
+			rc = rename(tmp, path);
+		if (rc != 0)
+			unlink(tmp);
+	}
+	free(path);
+	return rc;
+}
+
+ssize_t read_file_at(int dirfd, const char *path, char *buf, size_t sz)
+{
+	int fd;
+	ssize_t n;
+
+	if (sz == 0)
+		return -1;
+	fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	n = read(fd, buf, sz - 1);
+	close(fd);
+	if (n < 0)
+		return -1;
+	while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' '))
+		n--;
+	buf[n] = '\0';
+	return n;
+}
+
+long read_long_at(int dirfd, const char *path, long def)
+{
+	char buf[32];
+	char *end;
+	long v;
+
+	if (read_file_at(dirfd, path, buf, sizeof(buf)) <= 0)
+		return def;
+	v = strtol(buf, &end, 10);
+	if (end == buf)
+		return def;
+	return v;
+}
+
+int debug_enabled(void)
+{
+	static int enabled = -1;
+
+	if (enabled < 0) {
+		const char *e = getenv("CFETCH_DEBUG");
+
+		enabled = e && *e && strcmp(e, "0") != 0;
+	}
+	return enabled;
+}
+
+void debug_log(const char *fmt, ...)
+{
+	va_list ap;
+
+	if (!debug_enabled())
+		return;
+	fputs("cfetch: ", stderr);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+char *read_file_alloc(const char *path, size_t *out_len)
+{
+	size_t cap = 16384;
+	size_t len = 0;
+	char *buf;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+	buf = malloc(cap);
+	while (buf) {
+		ssize_t n;
+
+		if (len + 1 >= cap) {
+			char *tmp = realloc(buf, cap * 2);
+
+			if (!tmp) {
+				free(buf);
+				buf = NULL;
+				break;
+			}
+			buf = tmp;
+			cap *= 2;
+		}
+		n = read(fd, buf + len, cap - 1 - len);
+		if (n < 0) {
+			free(buf);
+			buf = NULL;
+			break;
+		}
+		if (n == 0)
+			break;
+		len += (size_t)n;
+	}
+	close(fd);
+	if (!buf)
+		return NULL;
+	buf[len] = '\0';
+	if (out_len)
+		*out_len = len;
+	return buf;
+}
+
+long read_long_hex_at(int dirfd, const char *path)
+{
+	char buf[32];
+	char *end;
+	long v;
+
+	if (read_file_at(dirfd, path, buf, sizeof(buf)) <= 0)
+		return -1;
+	v = strtol(buf, &end, 16);
+	if (end == buf)
+		return -1;
+	return v;
+}
+
+struct width_range {
+	uint32_t first;
+	uint32_t last;
+};
+
+/* Combining marks and zero-width format characters. */
+static const struct width_range zero_width[] = {
+	{ 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x05BF, 0x05BF },
+	{ 0x05C1, 0x05C2 }, { 0x05C4, 0x05C5 }, { 0x05C7, 0x05C7 }, { 0x0610, 0x061A },
+	{ 0x064B, 0x065F }, { 0x0670, 0x0670 }, { 0x06D6, 0x06DC }, { 0x06DF, 0x06E4 },
+	{ 0x06E7, 0x06E8 }, { 0x06EA, 0x06ED }, { 0x0900, 0x0902 }, { 0x093A, 0x093A },
+	{ 0x093C, 0x093C }, { 0x0941, 0x0948 }, { 0x094D, 0x094D }, { 0x0951, 0x0957 },
+	{ 0x0E31, 0x0E31 }, { 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E }, { 0x1AB0, 0x1AFF },
+	{ 0x1DC0, 0x1DFF }, { 0x200B, 0x200F }, { 0x202A, 0x202E }, { 0x2060, 0x2064 },
+	{ 0x20D0, 0x20FF }, { 0x302A, 0x302D }, { 0x3099, 0x309A }, { 0xFE00, 0xFE0F },
+	{ 0xFE20, 0xFE2F }, { 0xFEFF, 0xFEFF }, { 0x1F3FB, 0x1F3FF }, { 0xE0001, 0xE007F },
+	{ 0xE0100, 0xE01EF },
+};
+
+/* East Asian Wide and Fullwidth blocks, and emoji presented as wide. */
+static const struct width_range wide[] = {
+	{ 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC },
+	{ 0x23F0, 0x23F0 }, { 0x23F3, 0x23F3 }, { 0x25FD, 0x25FE }, { 0x2614, 0x2615 },
+	{ 0x2648, 0x2653 }, { 0x267F, 0x267F }, { 0x2693, 0x2693 }, { 0x26A1, 0x26A1 },
+	{ 0x26AA, 0x26AB }, { 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 }, { 0x26CE, 0x26CE },
+	{ 0x26D4, 0x26D4 }, { 0x26EA, 0x26EA }, { 0x26F2, 0x26F3 }, { 0x26F5, 0x26F5 },
+	{ 0x26FA, 0x26FA }, { 0x26FD, 0x26FD }, { 0x2705, 0x2705 }, { 0x270A, 0x270B },
+	{ 0x2728, 0x2728 }, { 0x274C, 0x274C }, { 0x274E, 0x274E }, { 0x2753, 0x2755 },
+	{ 0x2757, 0x2757 }, { 0x2795, 0x2797 }, { 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF },
+	{ 0x2B1B, 0x2B1C }, { 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 }, { 0x2E80, 0x303E },
+	{ 0x3041, 0x3247 }, { 0x3250, 0x4DBF }, { 0x4E00, 0xA4CF }, { 0xA960, 0xA97F },
+	{ 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6F },
+	{ 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x16FE0, 0x16FE4 }, { 0x17000, 0x18CFF },
+	{ 0x1B000, 0x1B2FF }, { 0x1F004, 0x1F004 }, { 0x1F0CF, 0x1F0CF }, { 0x1F18E, 0x1F18E },
+	{ 0x1F191, 0x1F19A }, { 0x1F200, 0x1F251 }, { 0x1F300, 0x1F320 }, { 0x1F32D, 0x1F335 },
+	{ 0x1F337, 0x1F37C }, { 0x1F37E, 0x1F393 }, { 0x1F3A0, 0x1F3CA }, { 0x1F3CF, 0x1F3D3 },
+	{ 0x1F3E0, 0x1F3F0 }, { 0x1F3F4, 0x1F3F4 }, { 0x1F3F8, 0x1F43E }, { 0x1F440, 0x1F440 },
+	{ 0x1F442, 0x1F4FC }, { 0x1F4FF, 0x1F53D }, { 0x1F54B, 0x1F54E }, { 0x1F550, 0x1F567 },
+	{ 0x1F57A, 0x1F57A }, { 0x1F595, 0x1F596 }, { 0x1F5A4, 0x1F5A4 }, { 0x1F5FB, 0x1F64F },
+	{ 0x1F680, 0x1F6C5 }, { 0x1F6CC, 0x1F6CC }, { 0x1F6D0, 0x1F6D2 }, { 0x1F6D5, 0x1F6D7 },
+	{ 0x1F6EB, 0x1F6EC }, { 0x1F6F4, 0x1F6FC }, { 0x1F7E0, 0x1F7EB }, { 0x1F90C, 0x1F93A },
+	{ 0x1F93C, 0x1F945 }, { 0x1F947, 0x1F9FF }, { 0x1FA70, 0x1FAFF }, { 0x20000, 0x2FFFD },
+	{ 0x30000, 0x3FFFD },
+};
+
+static int in_ranges(const struct width_range *r, size_t n, uint32_t cp)
+{
+	size_t lo = 0, hi = n;
+
+	if (cp < r[0].first || cp > r[n - 1].last)
+		return 0;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (cp > r[mid].last)
+			lo = mid + 1;
+		else if (cp < r[mid].first)
+			hi = mid;
+		else
+			return 1;
+	}
+	return 0;
+}
+
+static int codepoint_width(uint32_t cp)
+{
+	/*
+	 * Everything below U+0300 but the C0 and C1 controls is narrow. A tab
+	 * counts as one column: where it lands depends on the tab stops and the
+	 * column it starts from, which the layout cannot know.
+	 */
+	if (cp < 0x300)
+		return (cp < 0x20 && cp != '\t') || (cp >= 0x7F && cp < 0xA0) ? 0 : 1;
+	if (in_ranges(zero_width, sizeof(zero_width) / sizeof(zero_width[0]), cp))
+		return 0;
+	if (in_ranges(wide, sizeof(wide) / sizeof(wide[0]), cp))
+		return 2;
+	return 1;
+}
+
+/* Decodes one sequence; malformed input yields the lead byte as a narrow character. */
+static size_t utf8_decode(const unsigned char *p, size_t len, uint32_t *cp)
+{
+	size_t n, i;
+	uint32_t c = p[0];
+
+	if (c < 0x80) {
+		*cp = c;
+		return 1;
+	}
+	if (c >= 0xC2 && c <= 0xDF) {
+		n = 2;
+		c &= 0x1F;
+	} else if (c >= 0xE0 && c <= 0xEF) {
+		n = 3;
+		c &= 0x0F;
+	} else if (c >= 0xF0 && c <= 0xF4) {
+		n = 4;
+		c &= 0x07;
+	} else {
+		*cp = 0xFFFD;
+		return 1;
+	}
+	if (n > len) {
+		*cp = 0xFFFD;
+		return 1;
+	}
+	for (i = 1; i < n; i++) {
+		if ((p[i] & 0xC0) != 0x80) {
+			*cp = 0xFFFD;
+			return 1;
+		}
+		c = (c << 6) | (p[i] & 0x3F);
+	}
+	*cp = c;
+	return n;
+}
+
+/* Length of the printable-ASCII run (0x20-0x7E, one column each) at the start of p. */
+static size_t ascii_run(const unsigned char *p, size_t len)
+{
+	size_t i = 0;
+
+#ifdef __SSE2__
+	const __m128i space = _mm_set1_epi8(0x20), del = _mm_set1_epi8(0x7F);
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+		/* Signed compare: bytes >= 0x80 are negative, so they test below 0x20 too. */
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del)));
+
+		if (mask)
+			return i + (size_t)__builtin_ctz((unsigned int)mask);
+	}
+#else
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w, d;
+
+		memcpy(&w, p + i, sizeof(w));
+		d = w ^ 0x7F7F7F7F7F7F7F7FULL;
+		/* Flags a byte that is >= 0x80, below 0x20 or 0x7F; may flag later bytes too. */
+		if ((w | ((w - 0x2020202020202020ULL) & ~w) | ((d - 0x0101010101010101ULL) & ~d)) &
+		    0x8080808080808080ULL)
+			break;
+	}
+#endif
+	while (i < len && p[i] >= 0x20 && p[i] < 0x7F)
+		i++;
+	return i;
+}
+
+size_t utf8_prefix_width(const char *s, size_t len, size_t max_cols, size_t *cols)
+{
+	const unsigned char *p = (const unsigned char *)s;
+	size_t i = 0, w = 0;
+
+	while (i < len && w < max_cols) {
+		size_t run = ascii_run(p + i, len - i);
+		uint32_t cp;
+		size_t n;
+		int cw;
+
+		if (run) {
+			if (run > max_cols - w)
+				run = max_cols - w;
+			i += run;
+			w += run;
+			continue;
+		}
+		n = utf8_decode(p + i, len - i, &cp);
+		cw = codepoint_width(cp);
+		if (w + (size_t)cw > max_cols)
+			break;
+		i += n;
+		w += (size_t)cw;
+	}
+	/* Keep trailing combining marks with the character they belong to. */
+	while (i < len && p[i] >= 0x80) {
+		uint32_t cp;
+		size_t n = utf8_decode(p + i, len - i, &cp);
+
+		if (codepoint_width(cp) != 0)
+			break;
+		i += n;
+	}
+	if (cols)
+		*cols = w;
+	return i;
+}
+
+size_t utf8_width(const char *s, size_t len)
+{
+	size_t cols;
+
+	if (!s)
+		return 0;
+	utf8_prefix_width(s, len, (size_t)-1, &cols);
+	return cols;
+}
@@ -4,6 +4,7 @@
 #define UTILS_H
 
 #include <stddef.h>
+#include <sys/types.h>
 void capitalize_first(char *s);
 char *xstrdup(const char *s);
 char *str_tolower_dup(const char *s);
@@ -14,4 +15,44 @@ char *read_kv_value(char *s);
 int parse_line_index(const char *s, int *out_idx);
 char *escape_c_string(const char *input);
 size_t strlen_safe(const char *s);
+
+/*
+ * Small per-user cache files under $XDG_CACHE_HOME/cfetch (or ~/.cache/cfetch).
+ * cache_read() returns 0 and a NUL-terminated buffer on success, -1 otherwise.
+ * cache_write() replaces the file atomically.
+ */
+char *cache_path(const char *name);
+int cache_read(const char *name, char *buf, size_t sz);
+int cache_write(const char *name, const char *data);
+
+/*
+ * Reads a small sysfs/procfs file (relative to dirfd, or absolute) with one
+ * openat()+read(), strips the trailing newline and NUL-terminates it.
+ * Returns the length, or -1 if the file could not be read.
+ */
+ssize_t read_file_at(int dirfd, const char *path, char *buf, size_t sz);
+long read_long_at(int dirfd, const char *path, long def);
+long read_long_hex_at(int dirfd, const char *path);
+
+/*
+ * Reads a whole file of unknown size (procfs tables such as /proc/net/dev)
+ * into a NUL-terminated heap buffer. The caller frees it.
+ */
+char *read_file_alloc(const char *path, size_t *out_len);
+
+/*
+ * Terminal columns taken by len bytes of UTF-8: 2 for East Asian wide and
+ * fullwidth characters, 0 for combining marks, zero-width formatting
+ * characters and control characters other than tab, 1 otherwise (a tab and
+ * each invalid byte count as one column). Runs of printable ASCII are
+ * measured 16 bytes at a time. utf8_prefix_width() gives
+ * the number of bytes of the longest prefix that fits in max_cols and
+ * stores its width in *cols.
+ */
+size_t utf8_width(const char *s, size_t len);
+size_t utf8_prefix_width(const char *s, size_t len, size_t max_cols, size_t *cols);
+
+/* Diagnostics on stderr, enabled by setting CFETCH_DEBUG=1. */
+int debug_enabled(void);
+void debug_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 #endif
\ No newline at end of file